@@ -0,0 +1,330 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* BackgroundModel.cpp                                                  */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+
+
+#include "BackgroundModel.h"
+
+// Qt header files
+#include <QRunnable>
+// Header file containing default values
+#include "DefaultValues.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Number of planes of model (running average: background; Gaussian mixture: weights, means, deviations of 3 components)
+#define BACKGROUND_RUNNING_AVERAGE_PLANES 1
+#define BACKGROUND_GAUSSIAN_MIXTURE_PLANES 9
+
+// Updates a band of rows of the model in a thread pool thread
+class BandUpdater : public QRunnable
+{
+
+public:
+    BandUpdater(BackgroundModel *backgroundModel, int yBegin, int yEnd)
+        : backgroundModel(backgroundModel), yBegin(yBegin), yEnd(yEnd) {}
+    void run() { backgroundModel->updateRows(yBegin,yEnd); }
+private:
+    BackgroundModel *backgroundModel;
+    int yBegin;
+    int yEnd;
+};
+
+// (a*b)>>15 with rounding (a, b: Q0.15 or Q8.7 values)
+static inline int mulRound(int a, int b)
+{
+    return (a*b+(1<<14))>>15;
+} // mulRound()
+
+static inline int clampShort(int a, int minValue, int maxValue)
+{
+    return (a<minValue) ? minValue : ((a>maxValue) ? maxValue : a);
+} // clampShort()
+
+// Running average: one pixel (as processed by runningAverageSSE2())
+static inline void runningAverage(uchar src, uchar &dst, short &bg, const BackgroundParameters &p)
+{
+    int d=(src<<7)-bg;
+    int ad=(d<0) ? -d : d;
+    dst=(ad>p.threshold) ? 255 : 0;
+    bg=(short)(bg+mulRound(d,p.learningRate));
+} // runningAverage()
+
+// Gaussian mixture: one pixel (as processed by gaussianMixtureSSE2())
+static inline void gaussianMixture(uchar src, uchar &dst, short *w[3], short *m[3], short *s[3], int i,
+                                   const BackgroundParameters &p)
+{
+    int x=src<<7;
+    int d[3], ad[3];
+    bool c[3];
+    // Matching component: first component (highest weight) within DEFAULT_BACKGROUND_GMM_MATCH_FACTOR deviations
+    bool matched=false;
+    for(int k=0;k<3;k++)
+    {
+        d[k]=x-m[k][i];
+        ad[k]=(d[k]<0) ? -d[k] : d[k];
+        c[k]=!matched&&(w[k][i]>0)&&(ad[k]<DEFAULT_BACKGROUND_GMM_MATCH_FACTOR*s[k][i]+1);
+        matched=matched||c[k];
+    }
+    // Background: matching component is one of the components making up the background ratio of the weight
+    bool background=c[0]||(c[1]&&(w[0][i]<p.backgroundRatio))||
+                    (c[2]&&(qMin(w[0][i]+w[1][i],32767)<p.backgroundRatio));
+    dst=background ? 0 : 255;
+    // Update weights, mean and deviation of matching component
+    for(int k=0;k<3;k++)
+    {
+        w[k][i]=(short)(w[k][i]+mulRound((c[k] ? 32767 : 0)-w[k][i],p.learningRate));
+        if(c[k])
+        {
+            m[k][i]=(short)(m[k][i]+mulRound(d[k],p.learningRate));
+            s[k][i]=(short)clampShort(s[k][i]+mulRound(ad[k]-s[k][i],p.learningRate),p.minDeviation,p.maxDeviation);
+        }
+    }
+    // No matching component: component with lowest weight is replaced
+    if(!matched)
+    {
+        w[2][i]=p.learningRate;
+        m[2][i]=(short)x;
+        s[2][i]=p.initialDeviation;
+    }
+    // Keep components sorted by weight
+    static const int pairs[3][2]={{0,1},{1,2},{0,1}};
+    for(int n=0;n<3;n++)
+    {
+        int k0=pairs[n][0], k1=pairs[n][1];
+        if(w[k1][i]>w[k0][i])
+        {
+            qSwap(w[k0][i],w[k1][i]);
+            qSwap(m[k0][i],m[k1][i]);
+            qSwap(s[k0][i],s[k1][i]);
+        }
+    }
+} // gaussianMixture()
+
+#ifdef __SSE2__
+// (a*b)>>15 with rounding for 8 values (as mulRound())
+static inline __m128i mulRoundSSE2(__m128i a, __m128i b)
+{
+    __m128i lo=_mm_mullo_epi16(a,b);
+    __m128i hi=_mm_mulhi_epi16(a,b);
+    __m128i round=_mm_set1_epi32(1<<14);
+    __m128i p0=_mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo,hi),round),15);
+    __m128i p1=_mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo,hi),round),15);
+    return _mm_packs_epi32(p0,p1);
+} // mulRoundSSE2()
+
+static inline __m128i selectSSE2(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask,a),_mm_andnot_si128(mask,b));
+} // selectSSE2()
+
+// Running average: 8 pixels
+static inline void runningAverageSSE2(const uchar *src, uchar *dst, short *bg, const BackgroundParameters &p)
+{
+    __m128i zero=_mm_setzero_si128();
+    __m128i x=_mm_slli_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)src),zero),7);
+    __m128i b=_mm_loadu_si128((const __m128i*)bg);
+    __m128i d=_mm_sub_epi16(x,b);
+    __m128i ad=_mm_max_epi16(d,_mm_sub_epi16(zero,d));
+    __m128i foreground=_mm_cmpgt_epi16(ad,_mm_set1_epi16(p.threshold));
+    _mm_storeu_si128((__m128i*)bg,_mm_add_epi16(b,mulRoundSSE2(d,_mm_set1_epi16(p.learningRate))));
+    _mm_storel_epi64((__m128i*)dst,_mm_packs_epi16(foreground,foreground));
+} // runningAverageSSE2()
+
+// Gaussian mixture: 8 pixels (components are selected/updated/sorted with masks instead of branches)
+static inline void gaussianMixtureSSE2(const uchar *src, uchar *dst, short *w[3], short *m[3], short *s[3], int i,
+                                       const BackgroundParameters &p)
+{
+    __m128i zero=_mm_setzero_si128();
+    __m128i one=_mm_set1_epi16(32767);
+    __m128i rate=_mm_set1_epi16(p.learningRate);
+    __m128i x=_mm_slli_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src+i)),zero),7);
+    __m128i wk[3], mk[3], sk[3], d[3], ad[3], c[3];
+    // Matching component: first component (highest weight) within DEFAULT_BACKGROUND_GMM_MATCH_FACTOR deviations
+    __m128i matched=zero;
+    for(int k=0;k<3;k++)
+    {
+        wk[k]=_mm_loadu_si128((const __m128i*)(w[k]+i));
+        mk[k]=_mm_loadu_si128((const __m128i*)(m[k]+i));
+        sk[k]=_mm_loadu_si128((const __m128i*)(s[k]+i));
+        d[k]=_mm_sub_epi16(x,mk[k]);
+        ad[k]=_mm_max_epi16(d[k],_mm_sub_epi16(zero,d[k]));
+        __m128i limit=_mm_add_epi16(_mm_mullo_epi16(sk[k],_mm_set1_epi16(DEFAULT_BACKGROUND_GMM_MATCH_FACTOR)),_mm_set1_epi16(1));
+        c[k]=_mm_andnot_si128(matched,_mm_and_si128(_mm_cmpgt_epi16(wk[k],zero),_mm_cmplt_epi16(ad[k],limit)));
+        matched=_mm_or_si128(matched,c[k]);
+    }
+    // Background: matching component is one of the components making up the background ratio of the weight
+    __m128i ratio=_mm_set1_epi16(p.backgroundRatio);
+    __m128i background=_mm_or_si128(c[0],_mm_or_si128(
+                                        _mm_and_si128(c[1],_mm_cmplt_epi16(wk[0],ratio)),
+                                        _mm_and_si128(c[2],_mm_cmplt_epi16(_mm_adds_epi16(wk[0],wk[1]),ratio))));
+    __m128i foreground=_mm_andnot_si128(background,_mm_set1_epi16(-1));
+    _mm_storel_epi64((__m128i*)(dst+i),_mm_packs_epi16(foreground,foreground));
+    // Update weights, mean and deviation of matching component
+    __m128i minDeviation=_mm_set1_epi16(p.minDeviation);
+    __m128i maxDeviation=_mm_set1_epi16(p.maxDeviation);
+    for(int k=0;k<3;k++)
+    {
+        wk[k]=_mm_add_epi16(wk[k],mulRoundSSE2(_mm_sub_epi16(_mm_and_si128(c[k],one),wk[k]),rate));
+        mk[k]=selectSSE2(c[k],_mm_add_epi16(mk[k],mulRoundSSE2(d[k],rate)),mk[k]);
+        __m128i deviation=_mm_add_epi16(sk[k],mulRoundSSE2(_mm_sub_epi16(ad[k],sk[k]),rate));
+        deviation=_mm_min_epi16(_mm_max_epi16(deviation,minDeviation),maxDeviation);
+        sk[k]=selectSSE2(c[k],deviation,sk[k]);
+    }
+    // No matching component: component with lowest weight is replaced
+    wk[2]=selectSSE2(matched,wk[2],rate);
+    mk[2]=selectSSE2(matched,mk[2],x);
+    sk[2]=selectSSE2(matched,sk[2],_mm_set1_epi16(p.initialDeviation));
+    // Keep components sorted by weight
+    static const int pairs[3][2]={{0,1},{1,2},{0,1}};
+    for(int n=0;n<3;n++)
+    {
+        int k0=pairs[n][0], k1=pairs[n][1];
+        __m128i swap=_mm_cmpgt_epi16(wk[k1],wk[k0]);
+        __m128i t;
+        t=selectSSE2(swap,wk[k1],wk[k0]); wk[k1]=selectSSE2(swap,wk[k0],wk[k1]); wk[k0]=t;
+        t=selectSSE2(swap,mk[k1],mk[k0]); mk[k1]=selectSSE2(swap,mk[k0],mk[k1]); mk[k0]=t;
+        t=selectSSE2(swap,sk[k1],sk[k0]); sk[k1]=selectSSE2(swap,sk[k0],sk[k1]); sk[k0]=t;
+    }
+    for(int k=0;k<3;k++)
+    {
+        _mm_storeu_si128((__m128i*)(w[k]+i),wk[k]);
+        _mm_storeu_si128((__m128i*)(m[k]+i),mk[k]);
+        _mm_storeu_si128((__m128i*)(s[k]+i),sk[k]);
+    }
+} // gaussianMixtureSSE2()
+#endif
+
+BackgroundModel::BackgroundModel()
+{
+    modelMethod=-1;
+} // BackgroundModel constructor
+
+BackgroundModel::~BackgroundModel()
+{
+    // Wait for any tasks still running (tasks reference model)
+    threadPool.waitForDone();
+} // BackgroundModel destructor
+
+void BackgroundModel::reset()
+{
+    // Model is initialized from next frame
+    model.release();
+    modelMethod=-1;
+} // reset()
+
+void BackgroundModel::apply(const cv::Mat &frame, cv::Mat &mask, int method, double learningRate, int threshold)
+{
+    // Local variables
+    int nPlanes=(method==BACKGROUND_GAUSSIAN_MIXTURE) ? BACKGROUND_GAUSSIAN_MIXTURE_PLANES : BACKGROUND_RUNNING_AVERAGE_PLANES;
+
+    CV_Assert(frame.type()==CV_8UC1);
+    // Mask may be the frame itself (each pixel is read before it is written)
+    if((mask.size()!=frame.size())||(mask.type()!=CV_8UC1))
+        mask.create(frame.size(),CV_8UC1);
+    // Fixed-point parameters
+    parameters.learningRate=(short)qBound(1,cvRound(learningRate*32768),32767);
+    parameters.threshold=(short)(qBound(0,threshold,255)<<7);
+    parameters.initialDeviation=(short)(DEFAULT_BACKGROUND_GMM_INITIAL_DEVIATION<<7);
+    parameters.minDeviation=(short)(DEFAULT_BACKGROUND_GMM_MIN_DEVIATION<<7);
+    parameters.maxDeviation=(short)(DEFAULT_BACKGROUND_GMM_MAX_DEVIATION<<7);
+    parameters.backgroundRatio=(short)cvRound(DEFAULT_BACKGROUND_GMM_BACKGROUND_RATIO*32767);
+    // (Re)initialize model from frame if there is no model (of this size and method)
+    if((modelMethod!=method)||(model.rows!=nPlanes*frame.rows)||(model.cols!=frame.cols))
+    {
+        model.create(nPlanes*frame.rows,frame.cols,CV_16SC1);
+        model.setTo(cv::Scalar(0));
+        cv::Mat background=model.rowRange(0,frame.rows);
+        if(method==BACKGROUND_GAUSSIAN_MIXTURE)
+        {
+            // First component: weight 1, mean frame, initial deviation; other components are unused (weight 0)
+            model.rowRange(0,frame.rows).setTo(cv::Scalar(32767));
+            background=model.rowRange(3*frame.rows,4*frame.rows);
+            model.rowRange(6*frame.rows,9*frame.rows).setTo(cv::Scalar(parameters.initialDeviation));
+        }
+        frame.convertTo(background,CV_16S,128);
+        modelMethod=method;
+        mask.setTo(cv::Scalar(0));
+        return;
+    }
+    // Update model in bands of rows (bands are independent: every pixel has its own model)
+    currentFrame=frame;
+    currentMask=mask;
+    for(int y=0;y<frame.rows;y+=DEFAULT_BACKGROUND_BAND_ROWS)
+        threadPool.start(new BandUpdater(this,y,qMin(y+DEFAULT_BACKGROUND_BAND_ROWS,frame.rows)));
+    threadPool.waitForDone();
+    currentFrame.release();
+    currentMask.release();
+} // apply()
+
+void BackgroundModel::updateRows(int yBegin, int yEnd)
+{
+    // Called concurrently for different bands of rows
+    int width=currentFrame.cols;
+    int height=currentFrame.rows;
+    for(int y=yBegin;y<yEnd;y++)
+    {
+        const uchar *src=currentFrame.ptr<uchar>(y);
+        uchar *dst=currentMask.ptr<uchar>(y);
+        int i=0;
+        if(modelMethod==BACKGROUND_GAUSSIAN_MIXTURE)
+        {
+            short *w[3], *m[3], *s[3];
+            for(int k=0;k<3;k++)
+            {
+                w[k]=model.ptr<short>(k*height+y);
+                m[k]=model.ptr<short>((3+k)*height+y);
+                s[k]=model.ptr<short>((6+k)*height+y);
+            }
+#ifdef __SSE2__
+            for(;i+8<=width;i+=8)
+                gaussianMixtureSSE2(src,dst,w,m,s,i,parameters);
+#endif
+            for(;i<width;i++)
+                gaussianMixture(src[i],dst[i],w,m,s,i,parameters);
+        }
+        else
+        {
+            short *bg=model.ptr<short>(y);
+#ifdef __SSE2__
+            for(;i+8<=width;i+=8)
+                runningAverageSSE2(src+i,dst+i,bg+i,parameters);
+#endif
+            for(;i<width;i++)
+                runningAverage(src[i],dst[i],bg[i],parameters);
+        }
+    }
+} // updateRows()
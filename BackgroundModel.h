@@ -0,0 +1,82 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* BackgroundModel.h                                                    */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+
+
+#ifndef BACKGROUNDMODEL_H
+#define BACKGROUNDMODEL_H
+
+// Qt header files
+#include <QThreadPool>
+// OpenCV header files
+#include <opencv2/core/core.hpp>
+
+// Background model methods
+#define BACKGROUND_RUNNING_AVERAGE 0
+#define BACKGROUND_GAUSSIAN_MIXTURE 1
+
+// BackgroundParameters structure definition
+// (fixed point: pixel values/deviations Q8.7, weights/rates Q0.15)
+struct BackgroundParameters{
+    short learningRate;
+    short threshold;
+    short initialDeviation;
+    short minDeviation;
+    short maxDeviation;
+    short backgroundRatio;
+};
+
+// Per-pixel background model of a grayscale frame: foreground mask marks pixels not explained by the model.
+// Running average: one background value per pixel (foreground if difference exceeds threshold).
+// Gaussian mixture: 3 weighted components per pixel (foreground if no component of the background matches).
+// Model is kept in 16-bit fixed point and updated 8 pixels at a time (SSE2), in bands of rows on a thread pool.
+class BackgroundModel
+{
+
+public:
+    BackgroundModel();
+    ~BackgroundModel();
+    void reset();
+    void apply(const cv::Mat &frame, cv::Mat &mask, int method, double learningRate, int threshold);
+    void updateRows(int yBegin, int yEnd);
+private:
+    QThreadPool threadPool;
+    cv::Mat model;
+    int modelMethod;
+    BackgroundParameters parameters;
+    cv::Mat currentFrame;
+    cv::Mat currentMask;
+};
+
+#endif // BACKGROUNDMODEL_H
@@ -0,0 +1,258 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* BlobExtractor.cpp                                                    */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+
+
+#include "BlobExtractor.h"
+
+// Qt header files
+#include <QRunnable>
+// Header file containing default values
+#include "DefaultValues.h"
+
+#include <algorithm>
+#include <cstring>
+
+// Labels a strip of rows in a thread pool thread
+class StripLabeller : public QRunnable
+{
+
+public:
+    StripLabeller(BlobExtractor *blobExtractor, int stripIndex)
+        : blobExtractor(blobExtractor), stripIndex(stripIndex) {}
+    void run() { blobExtractor->labelStrip(stripIndex); }
+private:
+    BlobExtractor *blobExtractor;
+    int stripIndex;
+};
+
+static inline int findRoot(std::vector<int> &parent, int i)
+{
+    // Path halving
+    while(parent[i]!=i)
+    {
+        parent[i]=parent[parent[i]];
+        i=parent[i];
+    }
+    return i;
+} // findRoot()
+
+static inline void unite(std::vector<int> &parent, int a, int b)
+{
+    // Root with the lower index is kept (labels do not depend on the order of unions)
+    a=findRoot(parent,a);
+    b=findRoot(parent,b);
+    if(a<b)
+        parent[b]=a;
+    else if(b<a)
+        parent[a]=b;
+} // unite()
+
+// Unites runs of consecutive rows that touch (8-connectivity): runs [a,aEnd) of upper row, [b,bEnd) of lower row
+// (runs of both rows are sorted by x: each pair of rows is merged in a single pass)
+static void uniteRows(std::vector<int> &parent, const BlobRun *runs, int offset, int a, int aEnd, int b, int bEnd)
+{
+    for(;b<bEnd;b++)
+    {
+        // Skip upper runs ending left of this run (they can not touch any later run either)
+        while((a<aEnd)&&(runs[a].xEnd<runs[b].xBegin))
+            a++;
+        for(int k=a;(k<aEnd)&&(runs[k].xBegin<=runs[b].xEnd);k++)
+            unite(parent,offset+k,offset+b);
+    }
+} // uniteRows()
+
+static bool blobLessThan(const Blob &a, const Blob &b)
+{
+    // Largest blobs first (ties in scan order)
+    if(a.area!=b.area)
+        return a.area>b.area;
+    if(a.boundingBox.y!=b.boundingBox.y)
+        return a.boundingBox.y<b.boundingBox.y;
+    return a.boundingBox.x<b.boundingBox.x;
+} // blobLessThan()
+
+BlobExtractor::BlobExtractor()
+{
+} // BlobExtractor constructor
+
+BlobExtractor::~BlobExtractor()
+{
+    // Wait for any tasks still running (tasks reference strips)
+    threadPool.waitForDone();
+} // BlobExtractor destructor
+
+void BlobExtractor::extract(const cv::Mat &mask, cv::Point offset, std::vector<Blob> &blobs)
+{
+    // Local variables
+    int nStrips=(mask.rows+DEFAULT_BLOBS_STRIP_ROWS-1)/DEFAULT_BLOBS_STRIP_ROWS;
+
+    CV_Assert(mask.type()==CV_8UC1);
+    blobs.clear();
+    // Label strips in parallel (strip buffers are kept between frames)
+    currentMask=mask;
+    strips.resize(nStrips);
+    for(int s=0;s<nStrips;s++)
+    {
+        strips[s].yBegin=s*DEFAULT_BLOBS_STRIP_ROWS;
+        strips[s].yEnd=qMin(strips[s].yBegin+DEFAULT_BLOBS_STRIP_ROWS,mask.rows);
+        threadPool.start(new StripLabeller(this,s));
+    }
+    threadPool.waitForDone();
+    currentMask.release();
+    // Concatenate runs and labels of all strips
+    std::vector<BlobRun> runs;
+    std::vector<int> stripFirstRun(nStrips+1,0);
+    for(int s=0;s<nStrips;s++)
+        stripFirstRun[s+1]=stripFirstRun[s]+(int)strips[s].runs.size();
+    runs.reserve(stripFirstRun[nStrips]);
+    parent.resize(stripFirstRun[nStrips]);
+    for(int s=0;s<nStrips;s++)
+    {
+        runs.insert(runs.end(),strips[s].runs.begin(),strips[s].runs.end());
+        for(int i=0;i<(int)strips[s].parent.size();i++)
+            parent[stripFirstRun[s]+i]=stripFirstRun[s]+strips[s].parent[i];
+    }
+    // Merge labels across strip borders (last row of strip with first row of next strip)
+    for(int s=0;s+1<nStrips;s++)
+    {
+        const BlobStrip &upper=strips[s];
+        const BlobStrip &lower=strips[s+1];
+        int nUpperRows=upper.yEnd-upper.yBegin;
+        uniteRows(parent,runs.empty() ? NULL : &runs[0],0,
+                  stripFirstRun[s]+upper.rowFirstRun[nUpperRows-1],stripFirstRun[s]+upper.rowFirstRun[nUpperRows],
+                  stripFirstRun[s+1]+lower.rowFirstRun[0],stripFirstRun[s+1]+lower.rowFirstRun[1]);
+    }
+    // Accumulate area, bounding box and centroid of each component
+    blobIndex.assign(runs.size(),-1);
+    sumX.clear();
+    sumY.clear();
+    for(int i=0;i<(int)runs.size();i++)
+    {
+        const BlobRun &r=runs[i];
+        int root=findRoot(parent,i);
+        int length=r.xEnd-r.xBegin;
+        if(blobIndex[root]<0)
+        {
+            Blob blob;
+            blob.boundingBox=cv::Rect(r.xBegin,r.y,length,1);
+            blob.area=0;
+            blobIndex[root]=(int)blobs.size();
+            blobs.push_back(blob);
+            sumX.push_back(0.);
+            sumY.push_back(0.);
+        }
+        int b=blobIndex[root];
+        blobs[b].boundingBox|=cv::Rect(r.xBegin,r.y,length,1);
+        blobs[b].area+=length;
+        sumX[b]+=length*(r.xBegin+r.xEnd-1)*0.5;
+        sumY[b]+=(double)length*r.y;
+    }
+    // Centroids; frame coordinates (offset of ROI)
+    for(int b=0;b<(int)blobs.size();b++)
+    {
+        blobs[b].centroid=cv::Point2f((float)(sumX[b]/blobs[b].area+offset.x),(float)(sumY[b]/blobs[b].area+offset.y));
+        blobs[b].boundingBox+=offset;
+    }
+    // Drop small blobs (noise) and keep the largest ones
+    std::vector<Blob>::iterator end=blobs.begin();
+    for(std::vector<Blob>::iterator b=blobs.begin();b!=blobs.end();b++)
+        if(b->area>=DEFAULT_BLOBS_MIN_AREA)
+            *end++=*b;
+    blobs.erase(end,blobs.end());
+    std::sort(blobs.begin(),blobs.end(),blobLessThan);
+    if((int)blobs.size()>DEFAULT_BLOBS_MAX_COUNT)
+        blobs.resize(DEFAULT_BLOBS_MAX_COUNT);
+} // extract()
+
+void BlobExtractor::labelStrip(int stripIndex)
+{
+    // Called concurrently for different strips
+    BlobStrip &strip=strips[stripIndex];
+    int width=currentMask.cols;
+    strip.runs.clear();
+    strip.parent.clear();
+    strip.rowFirstRun.resize(strip.yEnd-strip.yBegin+1);
+    for(int y=strip.yBegin;y<strip.yEnd;y++)
+    {
+        const uchar *row=currentMask.ptr<uchar>(y);
+        int first=(int)strip.runs.size();
+        strip.rowFirstRun[y-strip.yBegin]=first;
+        // Run-length encode row
+        int x=0;
+        while(x<width)
+        {
+            // Skip background 8 pixels at a time
+            quint64 word;
+            while(x+8<=width)
+            {
+                memcpy(&word,row+x,8);
+                if(word!=0)
+                    break;
+                x+=8;
+            }
+            while((x<width)&&(row[x]==0))
+                x++;
+            if(x==width)
+                break;
+            BlobRun run;
+            run.y=y;
+            run.xBegin=x;
+            while((x<width)&&(row[x]!=0))
+                x++;
+            run.xEnd=x;
+            strip.runs.push_back(run);
+            strip.parent.push_back((int)strip.parent.size());
+        }
+        // Label runs of this row from runs of previous row
+        if(y>strip.yBegin)
+            uniteRows(strip.parent,strip.runs.empty() ? NULL : &strip.runs[0],0,
+                      strip.rowFirstRun[y-strip.yBegin-1],first,first,(int)strip.runs.size());
+    }
+    strip.rowFirstRun[strip.yEnd-strip.yBegin]=(int)strip.runs.size();
+} // labelStrip()
+
+void drawBlobs( QPainter& painter, const std::vector<Blob>& blobs, double scale )
+{
+    painter.setPen( QPen( QColor(0,255,0), 1 ) );
+    for( std::vector<Blob>::const_iterator b = blobs.begin(); b != blobs.end(); b++ )
+    {
+        // Bounding box and centroid
+        painter.drawRect( QRectF( b->boundingBox.x*scale, b->boundingBox.y*scale,
+                                  b->boundingBox.width*scale, b->boundingBox.height*scale ) );
+        QPointF center( (b->centroid.x + 0.5)*scale, (b->centroid.y + 0.5)*scale );
+        painter.drawLine( center - QPointF( 3, 0 ), center + QPointF( 3, 0 ) );
+        painter.drawLine( center - QPointF( 0, 3 ), center + QPointF( 0, 3 ) );
+    }
+} // drawBlobs()
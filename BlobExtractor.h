@@ -0,0 +1,89 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* BlobExtractor.h                                                      */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+
+
+#ifndef BLOBEXTRACTOR_H
+#define BLOBEXTRACTOR_H
+
+#include "Structures.h"
+
+// Qt header files
+#include <QThreadPool>
+#include <QPainter>
+// OpenCV header files
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+// Run of foreground pixels [xBegin,xEnd) in row y
+struct BlobRun{
+    int y;
+    int xBegin;
+    int xEnd;
+};
+
+// Runs of a strip of rows, labelled within the strip (union-find over run indices)
+struct BlobStrip{
+    int yBegin;
+    int yEnd;
+    std::vector<BlobRun> runs;
+    std::vector<int> parent;
+    std::vector<int> rowFirstRun; // Index of first run of each row (one extra entry: number of runs)
+};
+
+// Connected components (8-connectivity) of a binary image: nonzero pixels are foreground.
+// Rows are run-length encoded and labelled in a single pass per strip (strips in parallel);
+// labels of runs touching across strip borders are merged afterwards.
+class BlobExtractor
+{
+
+public:
+    BlobExtractor();
+    ~BlobExtractor();
+    void extract(const cv::Mat &mask, cv::Point offset, std::vector<Blob> &blobs);
+    void labelStrip(int stripIndex);
+private:
+    QThreadPool threadPool;
+    cv::Mat currentMask;
+    std::vector<BlobStrip> strips;
+    std::vector<int> parent;
+    std::vector<int> blobIndex;
+    std::vector<double> sumX;
+    std::vector<double> sumY;
+};
+
+void drawBlobs( QPainter& painter, const std::vector<Blob>& blobs, double scale );
+
+#endif // BLOBEXTRACTOR_H
@@ -36,6 +36,7 @@
 #include <QtGui>
 // Header file containing default values
 #include "DefaultValues.h"
+#include "V4L2Capture.h"
 
 CameraConnectDialog::CameraConnectDialog(QWidget *parent) : QDialog(parent)
 {
@@ -49,11 +50,47 @@ CameraConnectDialog::CameraConnectDialog(QWidget *parent) : QDialog(parent)
     QRegExp rx2("[0-9]\\d{0,2}"); // Integers 0 to 999
     QRegExpValidator *validator2 = new QRegExpValidator(rx2, 0);
     imageBufferSizeEdit->setValidator(validator2);
+    // captureWidthEdit, captureHeightEdit (frame size) input string validation
+    QRegExp rx3("[0-9]\\d{0,4}"); // Integers 0 to 99999
+    QRegExpValidator *validator3 = new QRegExpValidator(rx3, 0);
+    captureWidthEdit->setValidator(validator3);
+    captureHeightEdit->setValidator(validator3);
+    // captureFPSEdit (frame rate) input string validation
+    QRegExp rx4("[0-9]\\d{0,2}(\\.\\d{0,3})?"); // Decimals 0 to 999.999
+    QRegExpValidator *validator4 = new QRegExpValidator(rx4, 0);
+    captureFPSEdit->setValidator(validator4);
+    // captureFourccEdit (pixel format) input string validation
+    QRegExp rx5("[A-Za-z0-9 ]{0,4}"); // Four characters
+    QRegExpValidator *validator5 = new QRegExpValidator(rx5, 0);
+    captureFourccEdit->setValidator(validator5);
     // Set imageBufferSizeEdit to default value
     imageBufferSizeEdit->setText(QString::number(DEFAULT_IMAGE_BUFFER_SIZE));
-    // Initially set deviceNumber and imageBufferSize to defaults
+    // Set lumaCaptureCheckBox to default value
+    lumaCaptureCheckBox->setChecked(DEFAULT_CAPTURE_LUMA_ON);
+    // Set v4l2CaptureCheckBox to default value
+    v4l2CaptureCheckBox->setChecked(DEFAULT_CAPTURE_V4L2_ON);
+    // Initially set deviceNumber, imageBufferSize, lumaCaptureOn and v4l2CaptureOn to defaults
     deviceNumber=-1;
     imageBufferSize=DEFAULT_IMAGE_BUFFER_SIZE;
+    lumaCaptureOn=DEFAULT_CAPTURE_LUMA_ON;
+    v4l2CaptureOn=DEFAULT_CAPTURE_V4L2_ON;
+    captureMode.width=DEFAULT_CAPTURE_WIDTH;
+    captureMode.height=DEFAULT_CAPTURE_HEIGHT;
+    captureMode.fps=DEFAULT_CAPTURE_FPS;
+    captureMode.fourcc=QString::fromUtf8(DEFAULT_CAPTURE_FOURCC);
+    captureMode.decodeScale=DEFAULT_CAPTURE_DECODE_SCALE;
+    // Set decodeScaleComboBox to default value (items: 1/1, 1/2, 1/4, 1/8)
+    for(int i=0;i<decodeScaleComboBox->count();i++)
+    {
+        if((1<<i)==DEFAULT_CAPTURE_DECODE_SCALE)
+            decodeScaleComboBox->setCurrentIndex(i);
+    }
+    // Modes supported by selected camera are listed (list is updated when camera selection changes)
+    connect(anyCameraButton,SIGNAL(clicked()),this,SLOT(updateCaptureModes()));
+    connect(deviceNumberButton,SIGNAL(clicked()),this,SLOT(updateCaptureModes()));
+    connect(deviceNumberEdit,SIGNAL(editingFinished()),this,SLOT(updateCaptureModes()));
+    connect(captureModeComboBox,SIGNAL(currentIndexChanged(int)),this,SLOT(captureModeChange(int)));
+    updateCaptureModes();
 } // CameraConnectDialog constructor
 
 void CameraConnectDialog::setDeviceNumber()
@@ -95,6 +132,39 @@ void CameraConnectDialog::setImageBufferSize()
         imageBufferSize=imageBufferSizeEdit->text().toInt();
 } // setImageBufferSize()
 
+void CameraConnectDialog::setLumaCapture()
+{
+    lumaCaptureOn=lumaCaptureCheckBox->isChecked();
+} // setLumaCapture()
+
+void CameraConnectDialog::setV4L2Capture()
+{
+    v4l2CaptureOn=v4l2CaptureCheckBox->isChecked();
+} // setV4L2Capture()
+
+void CameraConnectDialog::setCaptureMode()
+{
+    // Blank fields: driver default
+    captureMode.width=captureWidthEdit->text().isEmpty() ? DEFAULT_CAPTURE_WIDTH : captureWidthEdit->text().toInt();
+    captureMode.height=captureHeightEdit->text().isEmpty() ? DEFAULT_CAPTURE_HEIGHT : captureHeightEdit->text().toInt();
+    captureMode.fps=captureFPSEdit->text().isEmpty() ? DEFAULT_CAPTURE_FPS : captureFPSEdit->text().toDouble();
+    captureMode.fourcc=captureFourccEdit->text().isEmpty() ? QString::fromUtf8(DEFAULT_CAPTURE_FOURCC) : captureFourccEdit->text();
+    captureMode.decodeScale=1<<decodeScaleComboBox->currentIndex();
+    // Frame size is only requested if both width and height are given
+    if((captureMode.width>0)!=(captureMode.height>0))
+    {
+        QMessageBox::warning(this->parentWidget(), "WARNING:","Capture frame size incomplete.\nAutomatically set to driver default.");
+        captureMode.width=0;
+        captureMode.height=0;
+    }
+    // Pixel format must have four characters
+    if(!captureMode.fourcc.isEmpty()&&(captureMode.fourcc.size()!=4))
+    {
+        QMessageBox::warning(this->parentWidget(), "WARNING:","Capture FOURCC must have four characters.\nAutomatically set to driver default.");
+        captureMode.fourcc.clear();
+    }
+} // setCaptureMode()
+
 int CameraConnectDialog::getDeviceNumber()
 {
     return deviceNumber;
@@ -104,3 +174,56 @@ int CameraConnectDialog::getImageBufferSize()
 {
     return imageBufferSize;
 } // getImageBufferSize()
+
+bool CameraConnectDialog::getLumaCaptureOn()
+{
+    return lumaCaptureOn;
+} // getLumaCaptureOn()
+
+bool CameraConnectDialog::getV4L2CaptureOn()
+{
+    return v4l2CaptureOn;
+} // getV4L2CaptureOn()
+
+struct CaptureMode CameraConnectDialog::getCaptureMode()
+{
+    return captureMode;
+} // getCaptureMode()
+
+void CameraConnectDialog::updateCaptureModes()
+{
+    // List modes of selected camera (first camera if any available camera is selected)
+    int device=(deviceNumberButton->isChecked()&&!deviceNumberEdit->text().isEmpty()) ? deviceNumberEdit->text().toInt() : 0;
+    captureModes=V4L2Capture::getModes(device);
+    captureModeComboBox->clear();
+    captureModeComboBox->addItem("Driver default");
+    for(int i=0;i<captureModes.size();i++)
+    {
+        const CaptureMode &mode=captureModes.at(i);
+        QString text=QString::number(mode.width)+QString("x")+QString::number(mode.height);
+        if(mode.fps>0)
+            text+=QString(" @ ")+QString::number(mode.fps,'f',(mode.fps==(int)mode.fps) ? 0 : 2)+QString(" fps");
+        captureModeComboBox->addItem(text+QString(" (")+mode.fourcc+QString(")"));
+    }
+} // updateCaptureModes()
+
+void CameraConnectDialog::captureModeChange(int index)
+{
+    // Driver default: fields are cleared
+    if(index<=0)
+    {
+        captureWidthEdit->clear();
+        captureHeightEdit->clear();
+        captureFPSEdit->clear();
+        captureFourccEdit->clear();
+    }
+    // Listed mode: fields are set to mode (and can then be edited)
+    else
+    {
+        const CaptureMode &mode=captureModes.at(index-1);
+        captureWidthEdit->setText(QString::number(mode.width));
+        captureHeightEdit->setText(QString::number(mode.height));
+        captureFPSEdit->setText((mode.fps>0) ? QString::number(mode.fps) : QString());
+        captureFourccEdit->setText(mode.fourcc);
+    }
+} // captureModeChange()
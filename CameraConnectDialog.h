@@ -34,6 +34,7 @@
 #define CAMERACONNECTDIALOG_H
 
 #include "ui_CameraConnectDialog.h"
+#include "Structures.h"
 
 class CameraConnectDialog : public QDialog, private Ui::CameraConnectDialog
 {
@@ -43,11 +44,24 @@ public:
     CameraConnectDialog(QWidget *parent = 0);
     void setDeviceNumber();
     void setImageBufferSize();
+    void setLumaCapture();
+    void setV4L2Capture();
+    void setCaptureMode();
     int getDeviceNumber();
     int getImageBufferSize();
+    bool getLumaCaptureOn();
+    bool getV4L2CaptureOn();
+    struct CaptureMode getCaptureMode();
 private:
     int deviceNumber;
     int imageBufferSize;
+    bool lumaCaptureOn;
+    bool v4l2CaptureOn;
+    CaptureMode captureMode;
+    QList<CaptureMode> captureModes;
+private slots:
+    void updateCaptureModes();
+    void captureModeChange(int index);
 };
 
 #endif // CAMERACONNECTDIALOG_H
@@ -0,0 +1,159 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* CameraPipeline.cpp                                                   */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "CameraPipeline.h"
+#include "ImageBuffer.h"
+
+// Qt header files
+#include <QtGui>
+// Header file containing default values
+#include "DefaultValues.h"
+
+CameraPipeline::CameraPipeline(const CameraSettings &settings) : settings(settings)
+{
+    // Create image buffer with user-defined size
+    imageBuffer = new ImageBuffer(settings.imageBufferSize);
+    // Create capture thread with user-defined device number and capture mode (luma plane only if luma capture is ON, through V4L2 if V4L2 capture is ON)
+    captureThread = new CaptureThread(imageBuffer, settings.deviceNumber, settings.lumaOn, settings.v4l2On, settings.imageBufferSize, settings.mode);
+    // Create processing thread
+    processingThread = new ProcessingThread(imageBuffer,getInputSourceWidth(),getInputSourceHeight());
+} // CameraPipeline constructor
+
+CameraPipeline::~CameraPipeline()
+{
+    // Stop threads and clear image buffer
+    stopThreads();
+    // Check if threads have stopped
+    if(!captureThread->isRunning()&&!processingThread->isRunning())
+    {
+        // Disconnect camera if connected
+        if(captureThread->isCameraConnected())
+            captureThread->disconnectCamera();
+        // Delete processing and capture threads
+        delete processingThread;
+        delete captureThread;
+    }
+    // Delete image buffer
+    delete imageBuffer;
+} // CameraPipeline destructor
+
+bool CameraPipeline::isCameraConnected()
+{
+    return captureThread->isCameraConnected();
+} // isCameraConnected()
+
+void CameraPipeline::startThreads()
+{
+    /*
+    QThread::IdlePriority               0	scheduled only when no other threads are running.
+    QThread::LowestPriority             1	scheduled less often than LowPriority.
+    QThread::LowPriority                2	scheduled less often than NormalPriority.
+    QThread::NormalPriority             3	the default priority of the operating system.
+    QThread::HighPriority               4	scheduled more often than NormalPriority.
+    QThread::HighestPriority            5	scheduled more often than HighPriority.
+    QThread::TimeCriticalPriority	6	scheduled as often as possible.
+    QThread::InheritPriority            7	use the same priority as the creating thread. This is the default.
+    */
+    // Start capturing frames from camera
+    captureThread->start(QThread::IdlePriority);
+    // Start processing captured frames
+    processingThread->start();
+} // startThreads()
+
+void CameraPipeline::stopThreads()
+{
+    // Stop processing thread
+    if(processingThread->isRunning())
+        stopProcessingThread();
+    // Stop capture thread
+    if(captureThread->isRunning())
+        stopCaptureThread();
+    // Clear image buffer
+    clearImageBuffer();
+} // stopThreads()
+
+void CameraPipeline::stopCaptureThread()
+{
+    qDebug() << "About to stop capture thread (camera" << settings.deviceNumber << ")...";
+    captureThread->stopCaptureThread();
+    // Take frames off a FULL queue to allow the capture thread to finish
+    // (frames still being decoded when the capture thread stops are added to the queue too)
+    while(!captureThread->wait(DEFAULT_CAPTURE_STOP_INTERVAL))
+    {
+        if(imageBuffer->getSizeOfImageBuffer()==settings.imageBufferSize)
+        {
+            IplImage* temp;
+            temp=imageBuffer->getFrame();
+            imageBuffer->releaseFrame(temp);
+        }
+    }
+    qDebug() << "Capture thread successfully stopped.";
+} // stopCaptureThread()
+
+void CameraPipeline::stopProcessingThread()
+{
+    qDebug() << "About to stop processing thread (camera" << settings.deviceNumber << ")...";
+    processingThread->stopProcessingThread();
+    processingThread->wait();
+    qDebug() << "Processing thread successfully stopped.";
+} // stopProcessingThread()
+
+void CameraPipeline::clearImageBuffer()
+{
+    imageBuffer->clearBuffer();
+} // clearImageBuffer()
+
+int CameraPipeline::getInputSourceWidth()
+{
+    return captureThread->getInputSourceWidth();
+} // getInputSourceWidth()
+
+int CameraPipeline::getInputSourceHeight()
+{
+    return captureThread->getInputSourceHeight();
+} // getInputSourceHeight()
+
+struct CameraSettings CameraPipeline::getSettings()
+{
+    return settings;
+} // getSettings()
+
+struct ThreadStatistics CameraPipeline::getStatistics()
+{
+    // Take consistent snapshot of processing thread statistics and add capture statistics
+    ThreadStatistics statistics=processingThread->getStatistics();
+    statistics.captureRate=captureThread->getAvgFPS();
+    statistics.nDroppedFrames=captureThread->getNumberOfDroppedFrames();
+    return statistics;
+} // getStatistics()
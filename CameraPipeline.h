@@ -0,0 +1,68 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* CameraPipeline.h                                                     */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef CAMERAPIPELINE_H
+#define CAMERAPIPELINE_H
+
+#include "CaptureThread.h"
+#include "ProcessingThread.h"
+#include "Structures.h"
+
+class ImageBuffer;
+
+// One camera: image buffer shared by a capture thread (producer) and a processing thread (consumer)
+class CameraPipeline
+{
+
+public:
+    CameraPipeline(const CameraSettings &settings);
+    ~CameraPipeline();
+    ImageBuffer *imageBuffer;
+    ProcessingThread *processingThread;
+    CaptureThread *captureThread;
+    bool isCameraConnected();
+    void startThreads();
+    void stopThreads();
+    void clearImageBuffer();
+    int getInputSourceWidth();
+    int getInputSourceHeight();
+    struct CameraSettings getSettings();
+    struct ThreadStatistics getStatistics();
+private:
+    void stopCaptureThread();
+    void stopProcessingThread();
+    CameraSettings settings;
+};
+
+#endif // CAMERAPIPELINE_H
@@ -32,14 +32,61 @@
 
 #include "CaptureThread.h"
 #include "ImageBuffer.h"
+#include "V4L2Capture.h"
+#include "MjpegDecoder.h"
+
+// OpenCV header files
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/highgui/highgui.hpp>
 
 // Qt header files
 #include <QDebug>
+// Header file containing default values
+#include "DefaultValues.h"
 
-CaptureThread::CaptureThread(ImageBuffer *buffer, int deviceNumber):QThread(), imageBuffer(buffer)
+CaptureThread::CaptureThread(ImageBuffer *buffer, int deviceNumber, bool lumaOn, bool v4l2On, int imageBufferSize, const CaptureMode &mode):QThread(), imageBuffer(buffer), lumaOn(lumaOn)
 {
-    // Open camera
-    capture=cvCaptureFromCAM(deviceNumber);
+    capture=NULL;
+    v4l2Capture=NULL;
+    mjpegDecoder=NULL;
+    // Open camera through V4L2: frames are added to image buffer without copying (driver buffers are mapped)
+    if(v4l2On)
+    {
+        v4l2Capture=new V4L2Capture();
+        if(!v4l2Capture->open(deviceNumber,lumaOn,imageBufferSize+DEFAULT_V4L2_EXTRA_BUFFERS,mode))
+        {
+            delete v4l2Capture;
+            v4l2Capture=NULL;
+        }
+        // Compressed frames: capture thread only dequeues buffers, frames are decoded in parallel
+        else if(v4l2Capture->isCompressed())
+            mjpegDecoder=new MjpegDecoder(imageBuffer,v4l2Capture,lumaOn,mode.decodeScale);
+    }
+    // Open camera and request capture mode (backend picks nearest supported mode: properties report mode in use)
+    else
+    {
+        capture=cvCaptureFromCAM(deviceNumber);
+        if(capture!=NULL)
+        {
+            if(mode.fourcc.size()==4)
+            {
+                QByteArray fourcc=mode.fourcc.toLatin1();
+                cvSetCaptureProperty(capture,CV_CAP_PROP_FOURCC,CV_FOURCC(fourcc[0],fourcc[1],fourcc[2],fourcc[3]));
+            }
+            if((mode.width>0)&&(mode.height>0))
+            {
+                cvSetCaptureProperty(capture,CV_CAP_PROP_FRAME_WIDTH,mode.width);
+                cvSetCaptureProperty(capture,CV_CAP_PROP_FRAME_HEIGHT,mode.height);
+            }
+            if(mode.fps>0)
+                cvSetCaptureProperty(capture,CV_CAP_PROP_FPS,mode.fps);
+        }
+    }
+    // Luma capture: ask backend for frames in the native camera format (YUYV, MJPEG or grayscale) instead of BGR
+    // (luma plane is taken from these directly: colour conversion is skipped)
+    lumaFrame=NULL;
+    if(lumaOn&&(capture!=NULL))
+        cvSetCaptureProperty(capture,CV_CAP_PROP_CONVERT_RGB,0);
     // Initialize variables
     stopped=false;
     sampleNo=0;
@@ -65,21 +112,90 @@ void CaptureThread::run()
         stoppedMutex.unlock();
         /////////////////////////////////
         /////////////////////////////////
+        // V4L2 (compressed frames): hand buffer over to decoder (decoded frames are added to buffer in capture order)
+        if(mjpegDecoder!=NULL)
+        {
+            const uchar *data;
+            int size;
+            int bufferIndex=v4l2Capture->dequeueBuffer(DEFAULT_V4L2_DEQUEUE_TIMEOUT,&data,&size);
+            if(bufferIndex<0)
+                continue;
+            qint64 timestamp=QDateTime::currentMSecsSinceEpoch();
+            captureTime=t.elapsed();
+            t.start();
+            // Buffer is released undecoded if all decoder threads are busy (decoded frame replaces oldest frame in image
+            // buffer if it is full: processing always gets the freshest frames)
+            if(mjpegDecoder->getNumberOfPendingFrames()>=DEFAULT_MJPEG_DECODE_THREADS)
+            {
+                v4l2Capture->releaseBuffer(bufferIndex);
+                droppedFrames.ref();
+            }
+            else
+                mjpegDecoder->decode(bufferIndex,data,size,timestamp);
+            updateFPS(captureTime);
+            continue;
+        }
+        // V4L2: add frame to buffer without copying (driver buffer is queued again when frame is released)
+        // (no frame if none was captured within timeout: stop request is checked again)
+        if(v4l2Capture!=NULL)
+        {
+            IplImage *frame=v4l2Capture->dequeueFrame(DEFAULT_V4L2_DEQUEUE_TIMEOUT);
+            if(frame==NULL)
+                continue;
+            qint64 timestamp=QDateTime::currentMSecsSinceEpoch();
+            captureTime=t.elapsed();
+            t.start();
+            // Oldest frame in image buffer is dropped if it is full (returned to driver, which keeps capturing into it)
+            if(imageBuffer->replaceOldestFrame(frame,v4l2Capture,timestamp))
+                droppedFrames.ref();
+            updateFPS(captureTime);
+            continue;
+        }
+        // Grab frame: driver queue is drained at camera rate (frame is not decoded/converted yet)
+        if(!cvGrabFrame(capture))
+        {
+            qDebug() << "ERROR: Could not grab frame.";
+            msleep(DEFAULT_CAPTURE_GRAB_RETRY_INTERVAL);
+            continue;
+        }
+        qint64 timestamp=QDateTime::currentMSecsSinceEpoch();
         // Save capture time
         captureTime=t.elapsed();
         // Start timer (used to calculate capture rate)
         t.start();
-        // Capture and add frame to buffer
-        imageBuffer->addFrame(cvQueryFrame(capture));
+        // Retrieve (decode/convert) frame and add it to buffer: oldest frame in image buffer is dropped if it is full
+        // (luma plane only if luma capture is ON)
+        IplImage *frame=cvRetrieveFrame(capture);
+        if((frame!=NULL)&&lumaOn)
+            frame=extractLuma(frame);
+        // Frame which could not be retrieved or decoded is dropped
+        if(frame==NULL)
+            droppedFrames.ref();
+        else if(imageBuffer->replaceOldestFrame(frame,timestamp))
+            droppedFrames.ref();
         // Update statistics
         updateFPS(captureTime);
     }
+    // Wait for frames still being decoded
+    if(mjpegDecoder!=NULL)
+        mjpegDecoder->stop();
     qDebug() << "Stopping capture thread...";
 } // run()
 
 void CaptureThread::disconnectCamera()
 {
-    // Disconnect camera if connected
+    // Disconnect camera if connected (frames captured through V4L2 must have been released)
+    if(v4l2Capture!=NULL)
+    {
+        if(mjpegDecoder!=NULL)
+        {
+            delete mjpegDecoder;
+            mjpegDecoder=NULL;
+        }
+        delete v4l2Capture;
+        v4l2Capture=NULL;
+        qDebug() << "Camera successfully disconnected.";
+    }
     if(capture!=NULL)
     {
         cvReleaseCapture(&capture);
@@ -88,8 +204,57 @@ void CaptureThread::disconnectCamera()
         else
             qDebug() << "ERROR: Camera could not be disconnected.";
     }
+    // Release luma frame
+    if(lumaFrame!=NULL)
+        cvReleaseImage(&lumaFrame);
 } // disconnectCamera()
 
+IplImage* CaptureThread::extractLuma(IplImage *frame)
+{
+    if(frame==NULL)
+        return NULL;
+    // Grayscale frame: already luma
+    if((frame->nChannels==1)&&(frame->height>1))
+        return frame;
+    // Compressed (MJPEG) frame is delivered as a single row of bytes: decode luma only (chroma is not decoded)
+    if(frame->nChannels==1)
+    {
+        cv::Mat decoded=cv::imdecode(cv::Mat(frame),CV_LOAD_IMAGE_GRAYSCALE);
+        if(decoded.empty())
+        {
+            qDebug() << "ERROR: Could not decode compressed frame.";
+            return NULL;
+        }
+        if((lumaFrame==NULL)||(lumaFrame->width!=decoded.cols)||(lumaFrame->height!=decoded.rows))
+        {
+            if(lumaFrame!=NULL)
+                cvReleaseImage(&lumaFrame);
+            lumaFrame=cvCreateImage(cvSize(decoded.cols,decoded.rows),IPL_DEPTH_8U,1);
+        }
+        cv::Mat luma(lumaFrame);
+        decoded.copyTo(luma);
+        return lumaFrame;
+    }
+    // (Re)create luma frame if frame dimensions have changed
+    if((lumaFrame==NULL)||(lumaFrame->width!=frame->width)||(lumaFrame->height!=frame->height))
+    {
+        if(lumaFrame!=NULL)
+            cvReleaseImage(&lumaFrame);
+        lumaFrame=cvCreateImage(cvSize(frame->width,frame->height),IPL_DEPTH_8U,1);
+    }
+    // Packed YUYV frame (2 channels: Y/U and Y/V): luma is the first channel of every pixel
+    if(frame->nChannels==2)
+    {
+        cv::Mat src(frame), dst(lumaFrame);
+        int fromTo[]={0,0};
+        cv::mixChannels(&src,1,&dst,1,fromTo,1);
+    }
+    // Backend delivered BGR anyway: convert here (in capture thread, not in processing thread)
+    else
+        cvCvtColor(frame,lumaFrame,CV_BGR2GRAY);
+    return lumaFrame;
+} // extractLuma()
+
 void CaptureThread::updateFPS(int timeElapsed)
 {
     // Add instantaneous FPS value to queue
@@ -121,6 +286,12 @@ void CaptureThread::stopCaptureThread()
     stoppedMutex.unlock();
 } // stopCaptureThread()
 
+int CaptureThread::getNumberOfDroppedFrames()
+{
+    // Frames dropped by capture thread and by decoder (oldest decoded frames replaced in image buffer)
+    return (int)droppedFrames+((mjpegDecoder!=NULL) ? mjpegDecoder->getNumberOfDroppedFrames() : 0);
+} // getNumberOfDroppedFrames()
+
 int CaptureThread::getAvgFPS()
 {
     return avgFPS;
@@ -128,7 +299,7 @@ int CaptureThread::getAvgFPS()
 
 bool CaptureThread::isCameraConnected()
 {
-    if(capture!=NULL)
+    if((capture!=NULL)||(v4l2Capture!=NULL))
         return true;
     else
         return false;
@@ -136,10 +307,18 @@ bool CaptureThread::isCameraConnected()
 
 int CaptureThread::getInputSourceWidth()
 {
+    if(mjpegDecoder!=NULL)
+        return mjpegDecoder->getScaledSize(v4l2Capture->getWidth());
+    if(v4l2Capture!=NULL)
+        return v4l2Capture->getWidth();
     return cvGetCaptureProperty(capture, CV_CAP_PROP_FRAME_WIDTH);
 } // getInputSourceWidth()
 
 int CaptureThread::getInputSourceHeight()
 {
+    if(mjpegDecoder!=NULL)
+        return mjpegDecoder->getScaledSize(v4l2Capture->getHeight());
+    if(v4l2Capture!=NULL)
+        return v4l2Capture->getHeight();
     return cvGetCaptureProperty(capture, CV_CAP_PROP_FRAME_HEIGHT);
 } // getInputSourceHeight()
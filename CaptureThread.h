@@ -39,24 +39,35 @@
 // OpenCV header files
 #include "opencv/highgui.h"
 
+#include "Structures.h"
+
 class ImageBuffer;
+class V4L2Capture;
+class MjpegDecoder;
 
 class CaptureThread : public QThread
 {
     Q_OBJECT
 
 public:
-    CaptureThread(ImageBuffer *buffer, int deviceNumber);
+    CaptureThread(ImageBuffer *buffer, int deviceNumber, bool lumaOn, bool v4l2On, int imageBufferSize, const CaptureMode &mode);
     void disconnectCamera();
     void stopCaptureThread();
     int getAvgFPS();
+    int getNumberOfDroppedFrames();
     bool isCameraConnected();
     int getInputSourceWidth();
     int getInputSourceHeight();
 private:
     void updateFPS(int);
+    IplImage* extractLuma(IplImage *frame);
     ImageBuffer *imageBuffer;
     CvCapture *capture;
+    V4L2Capture *v4l2Capture;
+    MjpegDecoder *mjpegDecoder;
+    IplImage *lumaFrame;
+    bool lumaOn;
+    QAtomicInt droppedFrames;
     QTime t;
     QMutex stoppedMutex;
     int captureTime;
@@ -0,0 +1,160 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* CascadeCache.cpp                                                     */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "CascadeCache.h"
+#include "DefaultValues.h"
+
+// Qt header files
+#include <QDebug>
+#include <QDesktopServices>
+#include <QDir>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThreadPool>
+
+// Loads cascade file in a thread pool thread
+class CascadeLoader : public QRunnable
+{
+
+public:
+    CascadeLoader(CascadeHandle cascade) : cascade(cascade) {}
+    void run() { cascade->load(); }
+private:
+    CascadeHandle cascade;
+};
+
+QMutex CascadeCache::mutex;
+QHash<QString,CascadeHandle> CascadeCache::cascades;
+
+Cascade::Cascade(const QString &filename) : filename(filename)
+{
+    // Initialize variables
+    loadingFinished=0;
+    loadingSucceeded=0;
+} // Cascade constructor
+
+bool Cascade::isLoading()
+{
+    return loadingFinished.fetchAndAddAcquire(0)==0;
+} // isLoading()
+
+bool Cascade::isLoaded()
+{
+    // Acquire: cascade state written by loading thread is visible once loading has succeeded
+    return loadingSucceeded.fetchAndAddAcquire(0)!=0;
+} // isLoaded()
+
+void Cascade::load()
+{
+    // Use binary cascade if present (no parsing required)
+    QString binaryFilename=HaarCascade::binaryFilename(filename);
+    if(QFile::exists(binaryFilename)&&haarCascade.load(binaryFilename))
+    {
+        loadingSucceeded.fetchAndStoreRelease(1);
+        loadingFinished.fetchAndStoreRelease(1);
+        return;
+    }
+    // Else compile XML cascade for in-tree evaluator: binary cascade is kept in per-user cache directory
+    // (recompiled if XML cascade is newer or binary cascade is invalid;
+    //  tree-structured cascades cannot be compiled and are loaded from XML)
+    QString cacheDirectory=QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+    if(DEFAULT_CASCADE_COMPILE_XML&&!cacheDirectory.isEmpty()&&QDir().mkpath(cacheDirectory))
+    {
+        QFileInfo xmlFileInfo(filename);
+        binaryFilename=QDir(cacheDirectory).filePath(QString("%1-%2.bin")
+                                                     .arg(xmlFileInfo.completeBaseName())
+                                                     .arg(qHash(xmlFileInfo.absoluteFilePath()),8,16,QChar('0')));
+        QFileInfo binaryFileInfo(binaryFilename);
+        bool upToDate=binaryFileInfo.exists()&&(binaryFileInfo.lastModified()>=xmlFileInfo.lastModified());
+        if((upToDate&&haarCascade.load(binaryFilename))||
+           (HaarCascade::compile(filename,binaryFilename)&&haarCascade.load(binaryFilename)))
+        {
+            loadingSucceeded.fetchAndStoreRelease(1);
+            loadingFinished.fetchAndStoreRelease(1);
+            return;
+        }
+    }
+    // QString->cv::String
+    // see: http://stackoverflow.com/questions/4214369/how-to-convert-qstring-to-stdstring
+    cv::String cascadeFilename=filename.toUtf8().constData();
+    if(classifier.load(cascadeFilename))
+        loadingSucceeded.fetchAndStoreRelease(1);
+    else
+        qDebug() << "ERROR: Can not open cascade file:" << filename;
+    // Cascade state is published with release semantics (read with acquire semantics in detection threads)
+    loadingFinished.fetchAndStoreRelease(1);
+} // load()
+
+bool Cascade::detectMultiScale(const cv::Mat &image, std::vector<cv::Rect> &objects,
+                               double scaleFactor, int minNeighbors, int flags,
+                               cv::Size minSize, cv::Size maxSize)
+{
+    // Cascade is not available until loading has finished successfully
+    if(!isLoaded())
+        return false;
+    // Binary cascade: evaluator is re-entrant (CV_HAAR_SCALE_IMAGE behaviour is implied)
+    if(!haarCascade.empty())
+    {
+        haarCascade.detectMultiScale(image,objects,scaleFactor,minNeighbors,minSize,maxSize);
+        return true;
+    }
+    // detectMultiScale() is not re-entrant (classifier holds per-image feature evaluator state)
+    QMutexLocker locker(&detectMutex);
+    classifier.detectMultiScale(image,objects,scaleFactor,minNeighbors,flags,minSize,maxSize);
+    return true;
+} // detectMultiScale()
+
+HaarCascade* Cascade::getHaarCascade()
+{
+    // Binary evaluator (NULL if cascade is not loaded or was loaded from XML)
+    if(!isLoaded()||haarCascade.empty())
+        return NULL;
+    return &haarCascade;
+} // getHaarCascade()
+
+CascadeHandle CascadeCache::getCascade(const QString &filename)
+{
+    // Cache is keyed by absolute file path
+    QFileInfo fileInfo(filename);
+    QString key=fileInfo.exists() ? fileInfo.canonicalFilePath() : fileInfo.absoluteFilePath();
+    QMutexLocker locker(&mutex);
+    // Return cached cascade (loaded or still loading)
+    if(cascades.contains(key))
+        return cascades.value(key);
+    // Create new cascade and load it in the background
+    CascadeHandle cascade(new Cascade(key));
+    cascades.insert(key,cascade);
+    QThreadPool::globalInstance()->start(new CascadeLoader(cascade));
+    return cascade;
+} // getCascade()
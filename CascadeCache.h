@@ -0,0 +1,82 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* CascadeCache.h                                                       */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef CASCADECACHE_H
+#define CASCADECACHE_H
+
+#include "HaarCascade.h"
+
+// Qt header files
+#include <QtGui>
+// OpenCV header files
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include <vector>
+
+// Cascade classifier shared by all pipelines: loaded once (in the background) and never modified afterwards
+// (binary cascade is memory-mapped if present or compiled from XML cascade, else XML cascade is loaded with cv::CascadeClassifier)
+class Cascade
+{
+
+public:
+    Cascade(const QString &filename);
+    bool isLoading();
+    bool isLoaded();
+    bool detectMultiScale(const cv::Mat &image, std::vector<cv::Rect> &objects,
+                          double scaleFactor, int minNeighbors, int flags,
+                          cv::Size minSize, cv::Size maxSize=cv::Size());
+    HaarCascade* getHaarCascade();
+    void load();
+private:
+    QString filename;
+    HaarCascade haarCascade;
+    cv::CascadeClassifier classifier;
+    QMutex detectMutex;
+    QAtomicInt loadingFinished;
+    QAtomicInt loadingSucceeded;
+};
+
+typedef QSharedPointer<Cascade> CascadeHandle;
+
+class CascadeCache
+{
+
+public:
+    static CascadeHandle getCascade(const QString &filename);
+private:
+    static QMutex mutex;
+    static QHash<QString,CascadeHandle> cascades;
+};
+
+#endif // CASCADECACHE_H
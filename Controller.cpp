@@ -31,78 +31,98 @@
 /************************************************************************/
 
 #include "Controller.h"
-#include "ImageBuffer.h"
 
 // Qt header files
 #include <QtGui>
+// Header file containing default values
+#include "DefaultValues.h"
 
-Controller::Controller(int deviceNumber, int imageBufferSize) : imageBufferSize(imageBufferSize)
+Controller::Controller()
 {
-    // Create image buffer with user-defined size
-    imageBuffer = new ImageBuffer(imageBufferSize);
-    // Create capture thread with user-defined device number
-    captureThread = new CaptureThread(imageBuffer, deviceNumber);
-    // Create processing thread
-    processingThread = new ProcessingThread(imageBuffer,getInputSourceWidth(),getInputSourceHeight());
 } // Controller constructor
 
 Controller::~Controller()
 {
-    // Delete image buffer
-    delete imageBuffer;
+    // Stop and delete all camera pipelines
+    disconnectAllCameras();
 } // Controller destructor
 
-void Controller::disconnectCamera()
+int Controller::connectToCamera(const CameraSettings &settings)
 {
-    captureThread->disconnectCamera();
-} // disconnectCamera()
+    // Returns device number of connected camera (-1 if camera could not be connected)
+    // Pipelines are keyed by the device actually opened: a device can only be opened by one pipeline
+    // Any available camera: first device not yet connected which can be opened
+    if(settings.deviceNumber<0)
+    {
+        CameraSettings deviceSettings=settings;
+        for(int deviceNumber=0;deviceNumber<DEFAULT_CAPTURE_MAX_DEVICES;deviceNumber++)
+        {
+            if(cameras.contains(deviceNumber))
+                continue;
+            deviceSettings.deviceNumber=deviceNumber;
+            if(openCamera(deviceSettings))
+                return deviceNumber;
+        }
+        qDebug() << "ERROR: No available camera could be connected.";
+        return -1;
+    }
+    if(cameras.contains(settings.deviceNumber))
+    {
+        qDebug() << "ERROR: Camera" << settings.deviceNumber << "is already connected.";
+        return -1;
+    }
+    return openCamera(settings) ? settings.deviceNumber : -1;
+} // connectToCamera()
 
-void Controller::stopCaptureThread()
+bool Controller::openCamera(const CameraSettings &settings)
 {
-    qDebug() << "About to stop capture thread...";
-    captureThread->stopCaptureThread();
-    // Take one frame off a FULL queue to allow the capture thread to finish
-    if(imageBuffer->getSizeOfImageBuffer()==imageBufferSize)
+    // Create pipeline (threads are started by caller)
+    CameraPipeline *camera=new CameraPipeline(settings);
+    if(!camera->isCameraConnected())
     {
-        IplImage* temp;
-        temp=imageBuffer->getFrame();
-        cvReleaseImage(&temp);
+        delete camera;
+        return false;
     }
-    captureThread->wait();
-    qDebug() << "Capture thread successfully stopped.";
-} // stopCaptureThread()
+    cameras.insert(settings.deviceNumber,camera);
+    return true;
+} // openCamera()
+
+void Controller::disconnectCamera(int deviceNumber)
+{
+    // Pipeline stops its threads and disconnects camera on deletion
+    delete cameras.take(deviceNumber);
+} // disconnectCamera()
 
-void Controller::stopProcessingThread()
+void Controller::disconnectAllCameras()
 {
-    qDebug() << "About to stop processing thread...";
-    processingThread->stopProcessingThread();
-    processingThread->wait();
-    qDebug() << "Processing thread successfully stopped.";
-} // stopProcessingThread()
+    QList<int> deviceNumbers=cameras.keys();
+    for(int i=0;i<deviceNumbers.size();i++)
+        disconnectCamera(deviceNumbers.at(i));
+} // disconnectAllCameras()
 
-void Controller::deleteCaptureThread()
+bool Controller::isCameraConnected(int deviceNumber)
 {
-    // Delete thread
-    delete captureThread;
-} // deleteCaptureThread()
+    return cameras.contains(deviceNumber);
+} // isCameraConnected()
 
-void Controller::deleteProcessingThread()
+CameraPipeline* Controller::getCamera(int deviceNumber)
 {
-    // Delete thread
-    delete processingThread;
-} // deleteProcessingThread()
+    // Returns NULL if camera is not connected
+    return cameras.value(deviceNumber);
+} // getCamera()
 
-void Controller::clearImageBuffer()
+QList<int> Controller::getDeviceNumbers()
 {
-    imageBuffer->clearBuffer();
-} // clearImageBuffer()
+    // Device numbers in ascending order
+    return cameras.keys();
+} // getDeviceNumbers()
 
-int Controller::getInputSourceWidth()
+int Controller::getNumberOfCameras()
 {
-    return captureThread->getInputSourceWidth();
-} // getInputSourceWidth()
+    return cameras.size();
+} // getNumberOfCameras()
 
-int Controller::getInputSourceHeight()
+struct ThreadStatistics Controller::getStatistics(int deviceNumber)
 {
-    return captureThread->getInputSourceHeight();
-} // getInputSourceHeight()
+    return cameras.value(deviceNumber)->getStatistics();
+} // getStatistics()
@@ -33,36 +33,31 @@
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
 
-#include "CaptureThread.h"
-#include "ProcessingThread.h"
+#include "CameraPipeline.h"
+#include "Structures.h"
 
 // Qt header files
 #include <QtGui>
-// OpenCV header files
-#include <opencv/highgui.h>
-
-class ImageBuffer;
 
+// Manages one pipeline per connected camera (cameras are identified by device number)
 class Controller : public QObject
 {
     Q_OBJECT
 
 public:
-    Controller(int deviceNumber, int imageBufferSize);
+    Controller();
     ~Controller();
-    ImageBuffer *imageBuffer;
-    ProcessingThread *processingThread;
-    CaptureThread *captureThread;
-    void disconnectCamera();
-    void stopCaptureThread();
-    void stopProcessingThread();
-    void deleteCaptureThread();
-    void deleteProcessingThread();
-    void clearImageBuffer();
-    int getInputSourceWidth();
-    int getInputSourceHeight();
+    int connectToCamera(const CameraSettings &settings);
+    void disconnectCamera(int deviceNumber);
+    void disconnectAllCameras();
+    bool isCameraConnected(int deviceNumber);
+    CameraPipeline* getCamera(int deviceNumber);
+    QList<int> getDeviceNumbers();
+    int getNumberOfCameras();
+    struct ThreadStatistics getStatistics(int deviceNumber);
 private:
-    int imageBufferSize;
+    bool openCamera(const CameraSettings &settings);
+    QMap<int,CameraPipeline*> cameras;
 };
 
 #endif // CONTROLLER_H
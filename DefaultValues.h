@@ -39,6 +39,26 @@
 
 // Image buffer size
 #define DEFAULT_IMAGE_BUFFER_SIZE 1
+// Capture luma plane only (grayscale)
+#define DEFAULT_CAPTURE_LUMA_ON false
+// Capture through V4L2 with mapped driver buffers (Linux only)
+#define DEFAULT_CAPTURE_V4L2_ON false
+// Capture mode requested from driver (0 or empty: driver default)
+#define DEFAULT_CAPTURE_WIDTH 0
+#define DEFAULT_CAPTURE_HEIGHT 0
+#define DEFAULT_CAPTURE_FPS 0
+#define DEFAULT_CAPTURE_FOURCC ""
+#define DEFAULT_CAPTURE_DECODE_SCALE 1 // MJPG frames (V4L2 capture) are decoded at 1/N of frame size [1,2,4,8]
+// Capture thread is stopped: image buffer is checked for a full queue every N ms until thread has finished
+#define DEFAULT_CAPTURE_STOP_INTERVAL 10
+// Capture thread waits N ms before grabbing again after a failed grab
+#define DEFAULT_CAPTURE_GRAB_RETRY_INTERVAL 100
+// Device numbers tried when connecting to any available camera
+#define DEFAULT_CAPTURE_MAX_DEVICES 64
+// Display refresh interval (ms)
+#define DEFAULT_DISPLAY_REFRESH_INTERVAL 16
+// Statistics refresh interval (ms)
+#define DEFAULT_STATISTICS_REFRESH_INTERVAL 250
 // SMOOTH
 #define DEFAULT_SMOOTH_TYPE CV_GAUSSIAN // Options: [CV_BLUR_NO_SCALE,CV_BLUR,CV_GAUSSIAN,CV_MEDIAN]
 #define DEFAULT_SMOOTH_PARAM_1 3
@@ -55,9 +75,64 @@
 #define DEFAULT_CANNY_THRESHOLD_1 10
 #define DEFAULT_CANNY_THRESHOLD_2 100
 #define DEFAULT_CANNY_APERTURE_SIZE 3
+#define DEFAULT_CANNY_BAND_ROWS 64 // Canny is computed in bands of N rows (in parallel)
+// BACKGROUND
+#define DEFAULT_BACKGROUND_METHOD 0 // 0: Running average, 1: Gaussian mixture
+#define DEFAULT_BACKGROUND_LEARNING_RATE 0.02 // Weight of current frame in model update
+#define DEFAULT_BACKGROUND_THRESHOLD 30 // Running average: pixel difference counted as foreground
+#define DEFAULT_BACKGROUND_GMM_MATCH_FACTOR 3 // Gaussian mixture: pixel matches component within N deviations
+#define DEFAULT_BACKGROUND_GMM_INITIAL_DEVIATION 15 // Gaussian mixture: deviation of new component
+#define DEFAULT_BACKGROUND_GMM_MIN_DEVIATION 4
+#define DEFAULT_BACKGROUND_GMM_MAX_DEVIATION 60
+#define DEFAULT_BACKGROUND_GMM_BACKGROUND_RATIO 0.7 // Gaussian mixture: components making up this fraction of the weight are background
+#define DEFAULT_BACKGROUND_BAND_ROWS 64 // Model is updated in bands of N rows (in parallel)
+// BLOBS
+#define DEFAULT_BLOBS_MIN_AREA 20 // Smaller blobs are dropped (pixels)
+#define DEFAULT_BLOBS_MAX_COUNT 256 // Only the largest N blobs are reported
+#define DEFAULT_BLOBS_STRIP_ROWS 64 // Image is labelled in strips of N rows (in parallel)
+// MOTION GATING
+#define DEFAULT_MOTION_GATING_ON false // Process only tiles that changed since they were last processed
+#define DEFAULT_MOTION_DOWNSAMPLE 4 // Motion is evaluated on frame downsampled by this factor
+#define DEFAULT_MOTION_TILE_SIZE 32 // Tiles of NxN pixels
+#define DEFAULT_MOTION_THRESHOLD 25 // Pixel difference counted as change
+#define DEFAULT_MOTION_TILE_FRACTION 0.05 // Fraction of changed pixels for a tile to count as changed
+#define DEFAULT_MOTION_FULL_FRAME_FRACTION 0.5 // Whole frame is processed if this fraction of tiles has changed
+#define DEFAULT_MOTION_CANNY_MARGIN 8 // Additional margin around changed regions for Canny (edge tracking is not local)
 // FACEDETECT
 #define DEFAULT_FACEDETECT_SCALE 1.0
 #define DEFAULT_FACEDETECT_CASCADE_FILENAME "haarcascades/haarcascade_frontalface_alt.xml"
 #define DEFAULT_FACEDETECT_NESTED_CASCADE_FILENAME "haarcascades/haarcascade_eye_tree_eyeglasses.xml"
+#define DEFAULT_FACEDETECT_ADDITIONAL_CASCADE_FILENAMES "" // Separated by ';' (e.g. "haarcascades/haarcascade_profileface.xml;haarcascades/haarcascade_upperbody.xml")
+#define DEFAULT_FACEDETECT_SCALE_FACTOR 1.1 // Scale step between pyramid levels
+#define DEFAULT_FACEDETECT_MIN_SIZE 30 // Minimum object size (downscaled image)
+#define DEFAULT_FACEDETECT_TRACKING_ON false // Track faces between full detections
+#define DEFAULT_FACEDETECT_DETECTION_INTERVAL 10 // Full detection every N frames (when tracking is ON)
+#define DEFAULT_FACEDETECT_TRACKING_MIN_SCORE 0.6 // Full detection is forced when a template match is weaker than this
+#define DEFAULT_FACEDETECT_TRACKING_SMOOTHING 0.5 // Weight of new tracked position [0.0-1.0]
+#define DEFAULT_FACEDETECT_SEARCH_REGIONS_ON false // Restrict detection to regions around previous faces and motion
+#define DEFAULT_FACEDETECT_FULL_SWEEP_INTERVAL 10 // Full-frame detection every N detections (when search regions are ON)
+#define DEFAULT_FACEDETECT_REGION_MIN_SIZE_FACTOR 0.7 // Object size range around previous face size
+#define DEFAULT_FACEDETECT_REGION_MAX_SIZE_FACTOR 1.4
+#define DEFAULT_FACEDETECT_MOTION_THRESHOLD 25 // Pixel difference counted as motion
+#define DEFAULT_FACEDETECT_MOTION_CELL_SIZE 16 // Motion is evaluated on cells of NxN pixels (downscaled image)
+#define DEFAULT_FACEDETECT_MOTION_CELL_FRACTION 0.05 // Fraction of changed pixels for a cell to count as motion
+#define DEFAULT_FACEDETECT_BUDGET_ON false // Adapt detector parameters to hold detection budget
+#define DEFAULT_FACEDETECT_BUDGET 20 // Detection budget (ms per frame; 1000/fps to hold a target frame rate)
+#define DEFAULT_FACEDETECT_BUDGET_MAX_LEVEL 12 // Maximum number of parameter degradation steps
+#define DEFAULT_FACEDETECT_BUDGET_AVERAGING 0.2 // Weight of new sample in average detection time
+#define DEFAULT_FACEDETECT_BUDGET_SETTLE_SAMPLES 8 // Samples between level changes
+#define DEFAULT_FACEDETECT_BUDGET_RECOVER_FRACTION 0.5 // Parameters are restored when cost is below this fraction of budget
+#define DEFAULT_FACEDETECT_BUDGET_SCALE_STEP 1.25 // Degradation steps
+#define DEFAULT_FACEDETECT_BUDGET_SCALE_FACTOR_STEP 0.05
+#define DEFAULT_FACEDETECT_BUDGET_MIN_SIZE_STEP 10
+#define DEFAULT_FACEDETECT_RESULTS_MAX_AGE 1000 // Detection results older than this (ms) are not overlaid
+// CASCADE EVALUATION
+#define DEFAULT_CASCADE_COMPILE_XML false // Compile XML cascades without binary cascade for the in-tree (SIMD) evaluator (cached per user)
+#define DEFAULT_DETECTION_ENGINE_BAND_ROWS 32 // Pyramid levels are evaluated in bands of N rows (must be even)
+// V4L2 CAPTURE
+#define DEFAULT_V4L2_EXTRA_BUFFERS 3 // Driver buffers in addition to image buffer size (processed frame, frame waiting to be added, frame being captured)
+#define DEFAULT_V4L2_DEQUEUE_TIMEOUT 100 // Capture thread checks for stop request at least every N ms
+// MJPEG DECODE
+#define DEFAULT_MJPEG_DECODE_THREADS 4 // Frames decoded in parallel (per camera)
 
 #endif // DEFAULTVALUES_H
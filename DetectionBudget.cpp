@@ -0,0 +1,100 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* DetectionBudget.cpp                                                  */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "DetectionBudget.h"
+
+// Header file containing default values
+#include "DefaultValues.h"
+
+DetectionBudget::DetectionBudget()
+{
+    reset();
+} // DetectionBudget constructor
+
+void DetectionBudget::reset()
+{
+    averageTime=0.0;
+    level=0;
+    nSamples=0;
+} // reset()
+
+void DetectionBudget::update(double detectionTime, int budget)
+{
+    // Average detection cost per frame (exponential moving average, restarted at each level change)
+    if(nSamples==0)
+        averageTime=detectionTime;
+    else
+        averageTime+=(detectionTime-averageTime)*DEFAULT_FACEDETECT_BUDGET_AVERAGING;
+    nSamples++;
+    // Level is only changed once the average has settled at the current level
+    if(nSamples<DEFAULT_FACEDETECT_BUDGET_SETTLE_SAMPLES)
+        return;
+    // Over budget: degrade one more parameter
+    if((averageTime>budget)&&(level<DEFAULT_FACEDETECT_BUDGET_MAX_LEVEL))
+    {
+        level++;
+        nSamples=0;
+    }
+    // Well below budget: restore last degraded parameter
+    else if((averageTime<budget*DEFAULT_FACEDETECT_BUDGET_RECOVER_FRACTION)&&(level>0))
+    {
+        level--;
+        nSamples=0;
+    }
+} // update()
+
+struct DetectionParameters DetectionBudget::getParameters(const struct DetectionParameters &baseParameters)
+{
+    DetectionParameters parameters=baseParameters;
+    // Each level degrades one parameter in turn: downscale factor, scale step, minimum object size, detection interval
+    for(int i=0;i<level;i++)
+    {
+        switch(i%4)
+        {
+            case 0:
+                parameters.scale*=DEFAULT_FACEDETECT_BUDGET_SCALE_STEP;
+                break;
+            case 1:
+                parameters.scaleFactor+=DEFAULT_FACEDETECT_BUDGET_SCALE_FACTOR_STEP;
+                break;
+            case 2:
+                parameters.minSize+=DEFAULT_FACEDETECT_BUDGET_MIN_SIZE_STEP;
+                break;
+            case 3:
+                parameters.detectionInterval++;
+                break;
+        }
+    }
+    return parameters;
+} // getParameters()
@@ -0,0 +1,201 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* DetectionEngine.cpp                                                  */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "DetectionEngine.h"
+#include "DefaultValues.h"
+
+// Qt header files
+#include <QRunnable>
+// OpenCV header files
+#include <opencv2/objdetect/objdetect.hpp>
+
+// Computes one pyramid level in a thread pool thread
+class LevelBuilder : public QRunnable
+{
+
+public:
+    LevelBuilder(const cv::Mat *image, double factor, bool tilted, HaarPyramidLevel *level)
+        : image(image), factor(factor), tilted(tilted), level(level) {}
+    void run() { HaarCascade::computeLevel(*image,factor,tilted,*level); }
+private:
+    const cv::Mat *image;
+    double factor;
+    bool tilted;
+    HaarPyramidLevel *level;
+};
+
+// Evaluates one binary cascade on a band of rows of one pyramid level in a thread pool thread
+class LevelDetector : public QRunnable
+{
+
+public:
+    LevelDetector(HaarCascade *haarCascade, const HaarPyramidLevel *level, int yBegin, int yEnd,
+                  cv::Size minSize, cv::Size maxSize, std::vector<cv::Rect> *candidates)
+        : haarCascade(haarCascade), level(level), yBegin(yBegin), yEnd(yEnd),
+          minSize(minSize), maxSize(maxSize), candidates(candidates) {}
+    void run() { haarCascade->detectAtLevel(*level,minSize,maxSize,*candidates,yBegin,yEnd); }
+private:
+    HaarCascade *haarCascade;
+    const HaarPyramidLevel *level;
+    int yBegin;
+    int yEnd;
+    cv::Size minSize;
+    cv::Size maxSize;
+    std::vector<cv::Rect> *candidates;
+};
+
+// Runs a cascade without binary evaluator (builds its own pyramid) in a thread pool thread
+class CascadeDetector : public QRunnable
+{
+
+public:
+    CascadeDetector(CascadeHandle cascade, const cv::Mat *image, double scaleFactor, int minNeighbors,
+                    cv::Size minSize, cv::Size maxSize, std::vector<cv::Rect> *objects)
+        : cascade(cascade), image(image), scaleFactor(scaleFactor), minNeighbors(minNeighbors),
+          minSize(minSize), maxSize(maxSize), objects(objects) {}
+    void run() { cascade->detectMultiScale(*image,*objects,scaleFactor,minNeighbors,CV_HAAR_SCALE_IMAGE,minSize,maxSize); }
+private:
+    CascadeHandle cascade;
+    const cv::Mat *image;
+    double scaleFactor;
+    int minNeighbors;
+    cv::Size minSize;
+    cv::Size maxSize;
+    std::vector<cv::Rect> *objects;
+};
+
+DetectionEngine::DetectionEngine()
+{
+} // DetectionEngine constructor
+
+DetectionEngine::~DetectionEngine()
+{
+    // Wait for any tasks still running (tasks reference pyramid and candidates)
+    threadPool.waitForDone();
+} // DetectionEngine destructor
+
+void DetectionEngine::detect(const cv::Mat &image, const std::vector<CascadeHandle> &cascades,
+                             double scaleFactor, int minNeighbors, cv::Size minSize, cv::Size maxSize,
+                             std::vector<std::vector<cv::Rect> > &objects)
+{
+    // Local variables
+    std::vector<HaarCascade*> haarCascades(cascades.size(),(HaarCascade*)NULL);
+    std::vector<double> factors;
+    std::vector<int> firstBand;
+    bool tilted=false;
+
+    objects.assign(cascades.size(),std::vector<cv::Rect>());
+    if(image.empty())
+        return;
+    if((maxSize.width<=0)||(maxSize.height<=0))
+        maxSize=image.size();
+    // Binary cascades share the pyramid (a tilted integral is computed if any of them needs it)
+    for(unsigned int i=0;i<cascades.size();i++)
+    {
+        if(cascades[i].isNull())
+            continue;
+        haarCascades[i]=cascades[i]->getHaarCascade();
+        if((haarCascades[i]!=NULL)&&haarCascades[i]->hasTiltedFeatures())
+            tilted=true;
+    }
+    // Pyramid levels: only levels at which at least one cascade window fits and is inside the object size range
+    for(double factor=1.;;factor*=scaleFactor)
+    {
+        cv::Size levelSize(cvRound(image.cols/factor),cvRound(image.rows/factor));
+        bool fits=false;
+        bool needed=false;
+        for(unsigned int i=0;i<cascades.size();i++)
+        {
+            if(haarCascades[i]==NULL)
+                continue;
+            cv::Size windowSize=haarCascades[i]->getWindowSize();
+            if((levelSize.width<=windowSize.width)||(levelSize.height<=windowSize.height))
+                continue;
+            fits=true;
+            cv::Size scaledWindowSize(cvRound(windowSize.width*factor),cvRound(windowSize.height*factor));
+            if((scaledWindowSize.width>=minSize.width)&&(scaledWindowSize.height>=minSize.height)&&
+               (scaledWindowSize.width<=maxSize.width)&&(scaledWindowSize.height<=maxSize.height))
+                needed=true;
+        }
+        if(!fits)
+            break;
+        if(needed)
+            factors.push_back(factor);
+    }
+    // Build pyramid levels in parallel (level buffers are reused from frame to frame)
+    if(pyramid.size()<factors.size())
+        pyramid.resize(factors.size());
+    for(unsigned int l=0;l<factors.size();l++)
+        threadPool.start(new LevelBuilder(&image,factors[l],tilted,&pyramid[l]));
+    threadPool.waitForDone();
+    // Large levels are split into bands of rows (band l of level starts at row b*DEFAULT_DETECTION_ENGINE_BAND_ROWS)
+    firstBand.assign(factors.size()+1,0);
+    for(unsigned int l=0;l<factors.size();l++)
+        firstBand[l+1]=firstBand[l]+(pyramid[l].image.rows+DEFAULT_DETECTION_ENGINE_BAND_ROWS-1)/DEFAULT_DETECTION_ENGINE_BAND_ROWS;
+    int nBands=firstBand[factors.size()];
+    // Evaluate all cascades on all bands of all levels in parallel (each task appends to its own candidate list)
+    candidates.resize(cascades.size()*nBands);
+    for(unsigned int i=0;i<cascades.size();i++)
+    {
+        if(haarCascades[i]!=NULL)
+        {
+            for(unsigned int l=0;l<factors.size();l++)
+            {
+                for(int b=firstBand[l];b<firstBand[l+1];b++)
+                {
+                    std::vector<cv::Rect> &bandCandidates=candidates[i*nBands+b];
+                    int yBegin=(b-firstBand[l])*DEFAULT_DETECTION_ENGINE_BAND_ROWS;
+                    bandCandidates.clear();
+                    threadPool.start(new LevelDetector(haarCascades[i],&pyramid[l],yBegin,yBegin+DEFAULT_DETECTION_ENGINE_BAND_ROWS,
+                                                       minSize,maxSize,&bandCandidates));
+                }
+            }
+        }
+        else if(!cascades[i].isNull()&&cascades[i]->isLoaded())
+            threadPool.start(new CascadeDetector(cascades[i],&image,scaleFactor,minNeighbors,minSize,maxSize,&objects[i]));
+    }
+    threadPool.waitForDone();
+    // Merge candidates of each binary cascade over all bands and levels
+    for(unsigned int i=0;i<cascades.size();i++)
+    {
+        if(haarCascades[i]==NULL)
+            continue;
+        for(int b=0;b<nBands;b++)
+        {
+            std::vector<cv::Rect> &bandCandidates=candidates[i*nBands+b];
+            objects[i].insert(objects[i].end(),bandCandidates.begin(),bandCandidates.end());
+        }
+        cv::groupRectangles(objects[i],minNeighbors,0.2);
+    }
+} // detect()
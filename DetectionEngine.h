@@ -0,0 +1,66 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* DetectionEngine.h                                                    */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef DETECTIONENGINE_H
+#define DETECTIONENGINE_H
+
+#include "CascadeCache.h"
+#include "HaarCascade.h"
+
+// Qt header files
+#include <QThreadPool>
+// OpenCV header files
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+// Runs several cascades on the same image: image pyramid and integral images are computed once and shared,
+// cascades, pyramid levels and bands of rows are evaluated in parallel on a thread pool
+// (cascades loaded from XML cannot share the pyramid and run as a single task each)
+class DetectionEngine
+{
+
+public:
+    DetectionEngine();
+    ~DetectionEngine();
+    void detect(const cv::Mat &image, const std::vector<CascadeHandle> &cascades,
+                double scaleFactor, int minNeighbors, cv::Size minSize, cv::Size maxSize,
+                std::vector<std::vector<cv::Rect> > &objects);
+private:
+    QThreadPool threadPool;
+    std::vector<HaarPyramidLevel> pyramid;
+    std::vector<std::vector<cv::Rect> > candidates;
+};
+
+#endif // DETECTIONENGINE_H
@@ -3,66 +3,135 @@
 using namespace std;
 using namespace cv;
 
-void faceDetect( IplImage *iplImage,
-                   CascadeClassifier& cascade, CascadeClassifier& nestedCascade,
-                   double scale)
+void prepareFaceDetectImage( const Mat& img, double scale, FaceDetectWorkspace& workspace )
 {
-    Mat img = cvarrToMat(iplImage);
-    int i = 0;
-    double t = 0;
-    vector<Rect> faces;
-    const static Scalar colors[] =  { CV_RGB(0,0,255),
-        CV_RGB(0,128,255),
-        CV_RGB(0,255,255),
-        CV_RGB(0,255,0),
-        CV_RGB(255,128,0),
-        CV_RGB(255,255,0),
-        CV_RGB(255,0,0),
-        CV_RGB(255,0,255)} ;
-    Mat gray, smallImg( cvRound (img.rows/scale), cvRound(img.cols/scale), CV_8UC1 );
+    const Mat* gray = &img;
+    Size smallSize( cvRound(img.cols/scale), cvRound(img.rows/scale) );
+
+    // Grayscale image (e.g. grayscale plane of processing pipeline) is used without colour conversion
+    if( img.channels() == 3 )
+    {
+        cvtColor( img, workspace.gray, CV_BGR2GRAY );
+        gray = &workspace.gray;
+    }
+    if( smallSize == gray->size() )
+        equalizeHist( *gray, workspace.smallImg );
+    else
+    {
+        resize( *gray, workspace.smallImg, smallSize, 0, 0, INTER_LINEAR );
+        equalizeHist( workspace.smallImg, workspace.smallImg );
+    }
+}
 
-    cvtColor( img, gray, CV_BGR2GRAY );
-    resize( gray, smallImg, smallImg.size(), 0, 0, INTER_LINEAR );
-    equalizeHist( smallImg, smallImg );
+bool detectObjects( DetectionEngine& engine, const Mat& smallImg,
+                   const vector<CascadeHandle>& cascades, vector<vector<Rect> >& objects,
+                   double scaleFactor, int minSize )
+{
+    // Face cascade (first cascade) must be loaded: additional cascades are used once loaded
+    if( !cascades[0]->isLoaded() )
+        return false;
+    engine.detect( smallImg, cascades, scaleFactor, 2, Size(minSize, minSize), Size(), objects );
+    return true;
+}
 
-    t = (double)cvGetTickCount();
-    cascade.detectMultiScale( smallImg, faces,
-        1.1, 2, 0
-        //|CV_HAAR_FIND_BIGGEST_OBJECT
-        //|CV_HAAR_DO_ROUGH_SEARCH
-        |CV_HAAR_SCALE_IMAGE
-        ,
-        Size(30, 30) );
-    t = (double)cvGetTickCount() - t;
-    //printf( "detection time = %g ms\n", t/((double)cvGetTickFrequency()*1000.) );
-    for( vector<Rect>::const_iterator r = faces.begin(); r != faces.end(); r++, i++ )
+bool detectFacesInRegions( const Mat& smallImg, const CascadeHandle& cascade,
+                   const vector<SearchRegion>& regions, vector<Rect>& faces,
+                   double scaleFactor, int minSize )
+{
+    faces.clear();
+    if( !cascade->isLoaded() )
+        return false;
+    for( vector<SearchRegion>::const_iterator r = regions.begin(); r != regions.end(); r++ )
     {
-        Mat smallImgROI;
-        vector<Rect> nestedObjects;
-        Point center;
-        Scalar color = colors[i%8];
-        int radius;
-        center.x = cvRound((r->x + r->width*0.5)*scale);
-        center.y = cvRound((r->y + r->height*0.5)*scale);
-        radius = cvRound((r->width + r->height)*0.25*scale);
-        circle( img, center, radius, color, 3, 8, 0 );
-        if( nestedCascade.empty() )
+        vector<Rect> regionFaces;
+        // Object size is restricted per region (but never below the full-frame minimum)
+        Size regionMinSize( max(r->minSize.width, minSize), max(r->minSize.height, minSize) );
+        if( r->rect.width < regionMinSize.width || r->rect.height < regionMinSize.height )
             continue;
-        smallImgROI = smallImg(*r);
-        nestedCascade.detectMultiScale( smallImgROI, nestedObjects,
-            1.1, 2, 0
+        cascade->detectMultiScale( smallImg(r->rect), regionFaces,
+            scaleFactor, 2, 0
             //|CV_HAAR_FIND_BIGGEST_OBJECT
             //|CV_HAAR_DO_ROUGH_SEARCH
-            //|CV_HAAR_DO_CANNY_PRUNING
             |CV_HAAR_SCALE_IMAGE
             ,
-            Size(30, 30) );
-        for( vector<Rect>::const_iterator nr = nestedObjects.begin(); nr != nestedObjects.end(); nr++ )
+            regionMinSize, r->maxSize );
+        for( vector<Rect>::iterator f = regionFaces.begin(); f != regionFaces.end(); f++ )
+        {
+            bool duplicate = false;
+            *f += r->rect.tl();
+            // Regions may overlap: skip faces already found in another region
+            for( vector<Rect>::const_iterator g = faces.begin(); g != faces.end() && !duplicate; g++ )
+                duplicate = (*f & *g).area() > min(f->area(), g->area())/2;
+            if( !duplicate )
+                faces.push_back( *f );
+        }
+    }
+    return true;
+}
+
+void detectNestedObjects( const Mat& smallImg, const vector<Rect>& faces,
+                   const CascadeHandle& nestedCascade, double scale, vector<FaceDetection>& detections )
+{
+    detections.clear();
+    for( vector<Rect>::const_iterator r = faces.begin(); r != faces.end(); r++ )
+    {
+        Mat smallImgROI;
+        vector<Rect> nestedObjects;
+        FaceDetection detection;
+        detection.cascadeIndex = 0;
+        // Detections are stored in image (not downscaled image) coordinates
+        detection.face = Rect( cvRound(r->x*scale), cvRound(r->y*scale),
+                               cvRound(r->width*scale), cvRound(r->height*scale) );
+        // Nested cascade is only run inside face rectangles
+        if( !nestedCascade.isNull() && nestedCascade->isLoaded() )
+        {
+            smallImgROI = smallImg(*r);
+            nestedCascade->detectMultiScale( smallImgROI, nestedObjects,
+                1.1, 2, 0
+                //|CV_HAAR_FIND_BIGGEST_OBJECT
+                //|CV_HAAR_DO_ROUGH_SEARCH
+                //|CV_HAAR_DO_CANNY_PRUNING
+                |CV_HAAR_SCALE_IMAGE
+                ,
+                Size(30, 30) );
+            for( vector<Rect>::const_iterator nr = nestedObjects.begin(); nr != nestedObjects.end(); nr++ )
+                detection.nestedObjects.push_back( Rect( cvRound((r->x + nr->x)*scale), cvRound((r->y + nr->y)*scale),
+                                                         cvRound(nr->width*scale), cvRound(nr->height*scale) ) );
+        }
+        detections.push_back( detection );
+    }
+}
+
+void drawFaceDetections( QPainter& painter, const vector<FaceDetection>& detections, double scale )
+{
+    int i = 0;
+    const static QColor colors[] =  { QColor(0,0,255),
+        QColor(0,128,255),
+        QColor(0,255,255),
+        QColor(0,255,0),
+        QColor(255,128,0),
+        QColor(255,255,0),
+        QColor(255,0,0),
+        QColor(255,0,255)} ;
+    for( vector<FaceDetection>::const_iterator d = detections.begin(); d != detections.end(); d++, i++ )
+    {
+        QPointF center;
+        double radius;
+        painter.setPen( QPen( colors[i%8], 3 ) );
+        // Objects of additional cascades are drawn as rectangles
+        if( d->cascadeIndex > 0 )
+        {
+            painter.drawRect( QRectF( d->face.x*scale, d->face.y*scale, d->face.width*scale, d->face.height*scale ) );
+            continue;
+        }
+        center = QPointF( (d->face.x + d->face.width*0.5)*scale, (d->face.y + d->face.height*0.5)*scale );
+        radius = (d->face.width + d->face.height)*0.25*scale;
+        painter.drawEllipse( center, radius, radius );
+        for( vector<Rect>::const_iterator nr = d->nestedObjects.begin(); nr != d->nestedObjects.end(); nr++ )
         {
-            center.x = cvRound((r->x + nr->x + nr->width*0.5)*scale);
-            center.y = cvRound((r->y + nr->y + nr->height*0.5)*scale);
-            radius = cvRound((nr->width + nr->height)*0.25*scale);
-            circle( img, center, radius, color, 3, 8, 0 );
+            center = QPointF( (nr->x + nr->width*0.5)*scale, (nr->y + nr->height*0.5)*scale );
+            radius = (nr->width + nr->height)*0.25*scale;
+            painter.drawEllipse( center, radius, radius );
         }
     }
 }
@@ -1,6 +1,11 @@
 #ifndef FACEDETECT_H
 #define FACEDETECT_H
 
+#include "CascadeCache.h"
+#include "Structures.h"
+#include "SearchRegionPredictor.h"
+#include "DetectionEngine.h"
+
 // Qt header files
 #include <QtGui>
 #include <QDebug>
@@ -10,9 +15,21 @@
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include <iostream>
+#include <vector>
+
+void prepareFaceDetectImage( const cv::Mat& img, double scale, FaceDetectWorkspace& workspace );
+
+bool detectObjects( DetectionEngine& engine, const cv::Mat& smallImg,
+                   const std::vector<CascadeHandle>& cascades, std::vector<std::vector<cv::Rect> >& objects,
+                   double scaleFactor, int minSize );
+
+bool detectFacesInRegions( const cv::Mat& smallImg, const CascadeHandle& cascade,
+                   const std::vector<SearchRegion>& regions, std::vector<cv::Rect>& faces,
+                   double scaleFactor, int minSize );
+
+void detectNestedObjects( const cv::Mat& smallImg, const std::vector<cv::Rect>& faces,
+                   const CascadeHandle& nestedCascade, double scale, std::vector<FaceDetection>& detections );
 
-void faceDetect( IplImage *iplImage,
-                   cv::CascadeClassifier& cascade, cv::CascadeClassifier& nestedCascade,
-                   double scale);
+void drawFaceDetections( QPainter& painter, const std::vector<FaceDetection>& detections, double scale );
 
 #endif // FACEDETECT_H
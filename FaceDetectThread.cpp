@@ -0,0 +1,336 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* FaceDetectThread.cpp                                                 */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "FaceDetectThread.h"
+#include "FaceDetect.h"
+
+// Qt header files
+#include <QDebug>
+// OpenCV header files
+#include <opencv/cv.h>
+// Header file containing default values
+#include "DefaultValues.h"
+
+FaceDetectThread::FaceDetectThread() : QThread()
+{
+    // Frame is created on first hand-over (size depends on ROI)
+    frame=NULL;
+    // Initialize variables
+    frameNumber=0;
+    frameTimestamp=0;
+    roiOffset=cvPoint(0,0);
+    scale=1.0;
+    trackingOn=false;
+    detectionInterval=1;
+    searchRegionsOn=false;
+    fullSweepInterval=1;
+    budgetOn=false;
+    budget=DEFAULT_FACEDETECT_BUDGET;
+    handOverInterval=1;
+    framesSinceDetection=0;
+    frameReady=false;
+    busy=false;
+    stopped=false;
+    sampleNo=0;
+    fpsSum=0;
+    avgFPS=0;
+    fps.clear();
+    results.frameNumber=-1;
+    results.timestamp=0;
+    results.detectionTime=0;
+    activeParameters.scale=DEFAULT_FACEDETECT_SCALE;
+    activeParameters.scaleFactor=DEFAULT_FACEDETECT_SCALE_FACTOR;
+    activeParameters.minSize=DEFAULT_FACEDETECT_MIN_SIZE;
+    activeParameters.detectionInterval=1;
+} // FaceDetectThread constructor
+
+FaceDetectThread::~FaceDetectThread()
+{
+    // Free IplImage (if it exists)
+    if(frame!=NULL)
+        cvReleaseImage(&frame);
+} // FaceDetectThread destructor
+
+void FaceDetectThread::run()
+{
+    std::vector<FaceDetection> detections;
+    std::vector<cv::Rect> faces;
+    FaceDetectResults newResults;
+    QTime detectionTimer;
+    std::vector<SearchRegion> regions;
+    std::vector<CascadeHandle> cascades;
+    std::vector<std::vector<cv::Rect> > objects;
+    DetectionParameters baseParameters;
+    DetectionParameters parameters;
+    cv::Mat &smallImg=workspace.smallImg;
+    while(1)
+    {
+        ///////////////////////////////////////////////////
+        // Wait for frame: stop thread if stopped=TRUE   //
+        ///////////////////////////////////////////////////
+        frameMutex.lock();
+        while(!frameReady&&!stopped)
+            frameAvailable.wait(&frameMutex);
+        if(stopped)
+        {
+            stopped=false;
+            frameMutex.unlock();
+            break;
+        }
+        // Take frame: processing thread does not touch it until detection has finished
+        frameReady=false;
+        busy=true;
+        int currentFrameNumber=frameNumber;
+        qint64 currentFrameTimestamp=frameTimestamp;
+        CvPoint currentROIOffset=roiOffset;
+        CascadeHandle currentCascade=cascade;
+        CascadeHandle currentNestedCascade=nestedCascade;
+        // Face cascade first, followed by additional cascades
+        cascades.assign(1,currentCascade);
+        for(int i=0;i<additionalCascades.size();i++)
+            cascades.push_back(additionalCascades.at(i));
+        double currentScale=scale;
+        bool currentTrackingOn=trackingOn;
+        int currentDetectionInterval=detectionInterval;
+        bool currentSearchRegionsOn=searchRegionsOn;
+        int currentFullSweepInterval=fullSweepInterval;
+        bool currentBudgetOn=budgetOn;
+        int currentBudget=budget;
+        int currentHandOverInterval=handOverInterval;
+        frameMutex.unlock();
+        ///////////////////////////////////////////////////
+        ///////////////////////////////////////////////////
+        // Save detection time
+        detectionTime=t.elapsed();
+        // Start timer (used to calculate detection rate)
+        t.start();
+        // Start timer (used to measure detection time of this frame)
+        detectionTimer.start();
+        // Detector parameters: settings, degraded by adaptive budget if over budget
+        // (without tracking, detection interval limits hand-over of frames)
+        baseParameters.scale=currentScale;
+        baseParameters.scaleFactor=DEFAULT_FACEDETECT_SCALE_FACTOR;
+        baseParameters.minSize=DEFAULT_FACEDETECT_MIN_SIZE;
+        baseParameters.detectionInterval=currentTrackingOn ? currentDetectionInterval : 1;
+        if(!currentBudgetOn)
+            detectionBudget.reset();
+        parameters=detectionBudget.getParameters(baseParameters);
+        // Perform detection
+        prepareFaceDetectImage(cv::cvarrToMat(frame),parameters.scale,workspace);
+        // Detect-then-track: faces are tracked between full detections (full detection also runs when tracking confidence drops)
+        bool detectionDue=!currentTrackingOn||(smallImg.size()!=trackedSize)||(framesSinceDetection+1>=parameters.detectionInterval);
+        if(!detectionDue&&tracker.track(smallImg,faces))
+            framesSinceDetection++;
+        else
+        {
+            // Detection is restricted to predicted regions (except for periodic full-frame sweeps)
+            bool detected;
+            if(!currentSearchRegionsOn)
+                predictor.reset();
+            if(currentSearchRegionsOn&&predictor.predict(smallImg,currentFullSweepInterval,regions))
+                detected=detectFacesInRegions(smallImg,currentCascade,regions,faces,parameters.scaleFactor,parameters.minSize);
+            else
+            {
+                // Full-frame sweep: all cascades share one image pyramid
+                detected=detectObjects(engine,smallImg,cascades,objects,parameters.scaleFactor,parameters.minSize);
+                if(detected)
+                {
+                    faces=objects[0];
+                    // Objects of additional cascades are updated on full-frame sweeps only
+                    additionalDetections.clear();
+                    for(unsigned int i=1;i<objects.size();i++)
+                    {
+                        for(std::vector<cv::Rect>::const_iterator r=objects[i].begin();r!=objects[i].end();r++)
+                        {
+                            FaceDetection detection;
+                            detection.cascadeIndex=i;
+                            detection.face=cv::Rect(cvRound(r->x*parameters.scale),cvRound(r->y*parameters.scale),
+                                                    cvRound(r->width*parameters.scale),cvRound(r->height*parameters.scale));
+                            additionalDetections.push_back(detection);
+                        }
+                    }
+                }
+            }
+            if(detected)
+            {
+                predictor.update(faces);
+                tracker.initialize(smallImg,faces);
+                trackedSize=smallImg.size();
+                framesSinceDetection=0;
+            }
+            else
+            {
+                // Cascade not loaded yet
+                faces.clear();
+                additionalDetections.clear();
+                predictor.reset();
+                tracker.reset();
+            }
+        }
+        // Nested cascade is only run inside detected/tracked faces
+        detectNestedObjects(smallImg,faces,currentNestedCascade,parameters.scale,detections);
+        if(cascades.size()==1)
+            additionalDetections.clear();
+        detections.insert(detections.end(),additionalDetections.begin(),additionalDetections.end());
+        // Convert detections to frame coordinates (frame was handed over with ROI set)
+        for(std::vector<FaceDetection>::iterator d=detections.begin();d!=detections.end();d++)
+        {
+            d->face+=cv::Point(currentROIOffset.x,currentROIOffset.y);
+            for(std::vector<cv::Rect>::iterator nr=d->nestedObjects.begin();nr!=d->nestedObjects.end();nr++)
+                *nr+=cv::Point(currentROIOffset.x,currentROIOffset.y);
+        }
+        // Publish results
+        newResults.frameNumber=currentFrameNumber;
+        newResults.timestamp=currentFrameTimestamp;
+        newResults.detectionTime=detectionTimer.elapsed();
+        newResults.detections.swap(detections);
+        resultsMutex.lock();
+        results=newResults;
+        activeParameters=parameters;
+        resultsMutex.unlock();
+        // Deliver results to any other consumers (logging, aggregation etc.)
+        emit newFaceDetectResults(newResults);
+        // Update statistics
+        updateFPS(detectionTime);
+        // Adaptive budget: cost per frame (detection time is shared by all frames of a hand-over interval)
+        if(currentBudgetOn)
+        {
+            detectionBudget.update((double)newResults.detectionTime/currentHandOverInterval,currentBudget);
+            parameters=detectionBudget.getParameters(baseParameters);
+        }
+        // Ready for next frame
+        frameMutex.lock();
+        busy=false;
+        handOverInterval=currentTrackingOn ? 1 : parameters.detectionInterval;
+        frameMutex.unlock();
+    } // while
+    qDebug() << "Stopping face detection thread...";
+} // run()
+
+bool FaceDetectThread::addFrame(IplImage *frame, int frameNumber, const ProcessingSettings &settings)
+{
+    // Called in processing thread: frame is dropped if detection of a previous frame is still in progress
+    // (or if hand-over interval has not passed yet)
+    QMutexLocker locker(&frameMutex);
+    if(frameReady||busy||(frameNumber-this->frameNumber<handOverInterval))
+        return false;
+    // (Re)create frame if dimensions or number of channels have changed (ROI of source frame is copied)
+    CvSize size=cvGetSize(frame);
+    if((this->frame==NULL)||(this->frame->width!=size.width)||(this->frame->height!=size.height)||
+       (this->frame->nChannels!=frame->nChannels))
+    {
+        if(this->frame!=NULL)
+            cvReleaseImage(&this->frame);
+        this->frame=cvCreateImage(size,frame->depth,frame->nChannels);
+    }
+    cvCopy(frame,this->frame);
+    // Detections are converted to frame coordinates using ROI offset
+    CvRect roi=cvGetImageROI(frame);
+    roiOffset=cvPoint(roi.x,roi.y);
+    // Store frame number, time of hand-over and detection settings
+    this->frameNumber=frameNumber;
+    frameTimestamp=QDateTime::currentMSecsSinceEpoch();
+    cascade=settings.facedetectCascade;
+    nestedCascade=settings.facedetectNestedCascade;
+    additionalCascades=settings.facedetectAdditionalCascades;
+    scale=settings.facedetectScale;
+    trackingOn=settings.facedetectTrackingOn;
+    detectionInterval=settings.facedetectDetectionInterval;
+    searchRegionsOn=settings.facedetectSearchRegionsOn;
+    fullSweepInterval=settings.facedetectFullSweepInterval;
+    budgetOn=settings.facedetectBudgetOn;
+    budget=settings.facedetectBudget;
+    // Wake thread
+    frameReady=true;
+    frameAvailable.wakeOne();
+    return true;
+} // addFrame()
+
+struct FaceDetectResults FaceDetectThread::getResults()
+{
+    QMutexLocker locker(&resultsMutex);
+    return results;
+} // getResults()
+
+void FaceDetectThread::clearResults()
+{
+    QMutexLocker locker(&resultsMutex);
+    results.frameNumber=-1;
+    results.timestamp=0;
+    results.detectionTime=0;
+    results.detections.clear();
+} // clearResults()
+
+void FaceDetectThread::updateFPS(int timeElapsed)
+{
+    // Add instantaneous FPS value to queue
+    if(timeElapsed>0)
+    {
+        fps.enqueue((int)1000/timeElapsed);
+        // Increment sample number
+        sampleNo++;
+    } // if
+    // Maximum size of queue is 16
+    if(fps.size() > 16)
+        fps.dequeue();
+    // Update FPS value every 16 samples
+    if((fps.size()==16)&&(sampleNo==16))
+    {
+        // Empty queue and store sum
+        while(!fps.empty())
+            fpsSum+=fps.dequeue();
+        avgFPS=fpsSum/16; // Calculate average FPS
+        fpsSum=0; // Reset sum
+        sampleNo=0; // Reset sample number
+    } // if
+} // updateFPS()
+
+void FaceDetectThread::stopFaceDetectThread()
+{
+    frameMutex.lock();
+    stopped=true;
+    frameAvailable.wakeOne();
+    frameMutex.unlock();
+} // stopFaceDetectThread()
+
+struct DetectionParameters FaceDetectThread::getParameters()
+{
+    QMutexLocker locker(&resultsMutex);
+    return activeParameters;
+} // getParameters()
+
+int FaceDetectThread::getAvgFPS()
+{
+    return avgFPS;
+} // getAvgFPS()
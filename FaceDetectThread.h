@@ -0,0 +1,118 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* FaceDetectThread.h                                                   */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef FACEDETECTTHREAD_H
+#define FACEDETECTTHREAD_H
+
+#include "Structures.h"
+#include "FaceTracker.h"
+#include "SearchRegionPredictor.h"
+#include "DetectionEngine.h"
+#include "DetectionBudget.h"
+
+// Qt header files
+#include <QThread>
+#include <QtGui>
+// OpenCV header files
+#include <opencv/highgui.h>
+
+// Face detection worker: runs at its own pace, detecting on the most recent frame handed over by the processing thread
+class FaceDetectThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    FaceDetectThread();
+    ~FaceDetectThread();
+    void stopFaceDetectThread();
+    bool addFrame(IplImage *frame, int frameNumber, const ProcessingSettings &settings);
+    struct FaceDetectResults getResults();
+    void clearResults();
+    int getAvgFPS();
+    struct DetectionParameters getParameters();
+private:
+    void updateFPS(int);
+    // Frame handed over by processing thread (owned by this thread while busy)
+    IplImage *frame;
+    int frameNumber;
+    qint64 frameTimestamp;
+    CvPoint roiOffset;
+    CascadeHandle cascade;
+    CascadeHandle nestedCascade;
+    QList<CascadeHandle> additionalCascades;
+    double scale;
+    bool trackingOn;
+    int detectionInterval;
+    bool searchRegionsOn;
+    int fullSweepInterval;
+    bool budgetOn;
+    int budget;
+    // Frames are handed over at most every N frames (adaptive budget without tracking)
+    int handOverInterval;
+    bool frameReady;
+    bool busy;
+    QMutex frameMutex;
+    QWaitCondition frameAvailable;
+    // Scratch images (kept for lifetime of thread)
+    FaceDetectWorkspace workspace;
+    // Detect-then-track state (only used in this thread)
+    FaceTracker tracker;
+    int framesSinceDetection;
+    cv::Size trackedSize;
+    // Search region prediction state (only used in this thread)
+    SearchRegionPredictor predictor;
+    // Full-frame detection of all cascades (only used in this thread)
+    DetectionEngine engine;
+    std::vector<FaceDetection> additionalDetections;
+    // Adaptive detection budget (only used in this thread)
+    DetectionBudget detectionBudget;
+    // Most recent detection results and detector parameters used
+    FaceDetectResults results;
+    DetectionParameters activeParameters;
+    QMutex resultsMutex;
+    QTime t;
+    int detectionTime;
+    QQueue<int> fps;
+    int fpsSum;
+    int sampleNo;
+    int avgFPS;
+    // Guarded by frameMutex (thread may be waiting for a frame when stopped)
+    bool stopped;
+protected:
+    void run();
+signals:
+    void newFaceDetectResults(struct FaceDetectResults faceDetectResults);
+};
+
+#endif // FACEDETECTTHREAD_H
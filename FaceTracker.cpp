@@ -0,0 +1,94 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* FaceTracker.cpp                                                      */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "FaceTracker.h"
+
+// OpenCV header files
+#include <opencv2/imgproc/imgproc.hpp>
+// Header file containing default values
+#include "DefaultValues.h"
+
+FaceTracker::FaceTracker()
+{
+} // FaceTracker constructor
+
+void FaceTracker::reset()
+{
+    tracks.clear();
+} // reset()
+
+void FaceTracker::initialize(const cv::Mat &image, const std::vector<cv::Rect> &faces)
+{
+    // Start one track per detected face (template is taken from the detection frame)
+    tracks.clear();
+    for(std::vector<cv::Rect>::const_iterator r=faces.begin();r!=faces.end();r++)
+    {
+        Track track;
+        track.templ=image(*r).clone();
+        track.position=cv::Point2f((float)r->x,(float)r->y);
+        tracks.push_back(track);
+    }
+} // initialize()
+
+bool FaceTracker::track(const cv::Mat &image, std::vector<cv::Rect> &faces)
+{
+    // Local variables
+    cv::Mat result;
+    double maxScore;
+    cv::Point maxLoc;
+
+    faces.clear();
+    for(std::vector<Track>::iterator track=tracks.begin();track!=tracks.end();track++)
+    {
+        int width=track->templ.cols;
+        int height=track->templ.rows;
+        // Search window: previous position expanded by half the face size on each side
+        cv::Rect search(cvRound(track->position.x)-width/2,cvRound(track->position.y)-height/2,2*width,2*height);
+        search&=cv::Rect(0,0,image.cols,image.rows);
+        // Face has left the image: confidence lost
+        if((search.width<width)||(search.height<height))
+            return false;
+        cv::matchTemplate(image(search),track->templ,result,CV_TM_CCOEFF_NORMED);
+        cv::minMaxLoc(result,NULL,&maxScore,NULL,&maxLoc);
+        // Match too weak: confidence lost
+        if(maxScore<DEFAULT_FACEDETECT_TRACKING_MIN_SCORE)
+            return false;
+        // Smooth position (reduces jitter of boxes between detections)
+        cv::Point2f match((float)(search.x+maxLoc.x),(float)(search.y+maxLoc.y));
+        track->position+=(match-track->position)*DEFAULT_FACEDETECT_TRACKING_SMOOTHING;
+        faces.push_back(cv::Rect(cvRound(track->position.x),cvRound(track->position.y),width,height)&
+                        cv::Rect(0,0,image.cols,image.rows));
+    }
+    return true;
+} // track()
@@ -40,6 +40,8 @@ FrameLabel::FrameLabel(QWidget *parent) : QLabel(parent)
     mouseCursorPos.setX(0);
     mouseCursorPos.setY(0);
     drawBox=false;
+    sourceFlipOn=false;
+    sourceFlipMode=0;
     // Initialize MouseData structure
     mouseData.leftButtonRelease=false;
     mouseData.rightButtonRelease=false;
@@ -52,8 +54,8 @@ void FrameLabel::mouseMoveEvent(QMouseEvent *ev)
     // Update box width and height if box drawing is in progress
     if(drawBox)
     {
-        box->setWidth(getMouseCursorPos().x()-startPoint.x());
-        box->setHeight(getMouseCursorPos().y()-startPoint.y());
+        box->setWidth(mouseCursorPos.x()-startPoint.x());
+        box->setHeight(mouseCursorPos.y()-startPoint.y());
     }
     // Inform main window of mouse move event
     emit onMouseMoveEvent();
@@ -66,9 +68,48 @@ void FrameLabel::setMouseCursorPos(QPoint input)
 
 QPoint FrameLabel::getMouseCursorPos()
 {
-    return mouseCursorPos;
+    // Return position in input source (not label) coordinates
+    return mapToSource(mouseCursorPos);
 } // getMouseXPos()
 
+void FrameLabel::setSourceSize(QSize input)
+{
+    sourceSize=input;
+} // setSourceSize()
+
+void FrameLabel::setSourceFlip(bool flipOn, int flipMode, QRect flipRect)
+{
+    // Displayed frame is flipped inside flipRect (flipMode as in cvFlip()): mouse coordinates are flipped back
+    sourceFlipOn=flipOn;
+    sourceFlipMode=flipMode;
+    sourceFlipRect=flipRect;
+} // setSourceFlip()
+
+QPoint FrameLabel::mapToSource(QPoint input)
+{
+    // Return unchanged point if no frame is being displayed
+    if((pixmap()==NULL)||pixmap()->isNull()||!sourceSize.isValid())
+        return input;
+    // Displayed frame is centered in label and may be downscaled from the input source
+    QSize displayedSize=pixmap()->size();
+    QRect contents=contentsRect();
+    int xOffset=contents.x()+(contents.width()-displayedSize.width())/2;
+    int yOffset=contents.y()+(contents.height()-displayedSize.height())/2;
+    QPoint point(qRound((double)(input.x()-xOffset)*sourceSize.width()/displayedSize.width()),
+                 qRound((double)(input.y()-yOffset)*sourceSize.height()/displayedSize.height()));
+    // Displayed frame may be flipped inside flipRect (ROI)
+    // (points on right/bottom edges of flipRect are included: selection box may end there)
+    if(sourceFlipOn&&(point.x()>=sourceFlipRect.x())&&(point.x()<=sourceFlipRect.x()+sourceFlipRect.width())&&
+       (point.y()>=sourceFlipRect.y())&&(point.y()<=sourceFlipRect.y()+sourceFlipRect.height()))
+    {
+        if(sourceFlipMode!=0)
+            point.setX(2*sourceFlipRect.x()+sourceFlipRect.width()-point.x());
+        if(sourceFlipMode<=0)
+            point.setY(2*sourceFlipRect.y()+sourceFlipRect.height()-point.y());
+    }
+    return point;
+} // mapToSource()
+
 void FrameLabel::mouseReleaseEvent(QMouseEvent *ev)
 {
     // Update cursor position
@@ -82,11 +123,13 @@ void FrameLabel::mouseReleaseEvent(QMouseEvent *ev)
         {
             // Stop drawing box
             drawBox=false;
-            // Save box dimensions
-            mouseData.selectionBox.setX(box->left());
-            mouseData.selectionBox.setY(box->top());
-            mouseData.selectionBox.setWidth(box->width());
-            mouseData.selectionBox.setHeight(box->height());
+            // Save box dimensions (mapped to input source coordinates)
+            QPoint boxStart=mapToSource(QPoint(box->x(),box->y()));
+            QPoint boxEnd=mapToSource(QPoint(box->x()+box->width(),box->y()+box->height()));
+            mouseData.selectionBox.setX(boxStart.x());
+            mouseData.selectionBox.setY(boxStart.y());
+            mouseData.selectionBox.setWidth(boxEnd.x()-boxStart.x());
+            mouseData.selectionBox.setHeight(boxEnd.y()-boxStart.y());
             // Set leftButtonRelease flag to TRUE
             mouseData.leftButtonRelease=true;
             // Inform main window of event
@@ -124,6 +167,8 @@ void FrameLabel::mousePressEvent(QMouseEvent *ev)
         box=new QRect(startPoint.x(),startPoint.y(),0,0);
         drawBox=true;
     }
+    // Inform main window of mouse press event
+    emit onMousePressEvent();
 } // mousePressEvent()
 
 void FrameLabel::paintEvent(QPaintEvent *ev)
@@ -137,3 +182,10 @@ void FrameLabel::paintEvent(QPaintEvent *ev)
         painter.drawRect(*box);
     }
 } // paintEvent()
+
+void FrameLabel::resizeEvent(QResizeEvent *ev)
+{
+    QLabel::resizeEvent(ev);
+    // Inform main window of resize event
+    emit onResizeEvent();
+} // resizeEvent()
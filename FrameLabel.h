@@ -46,20 +46,30 @@ public:
     FrameLabel(QWidget *parent = 0);
     void setMouseCursorPos(QPoint);
     QPoint getMouseCursorPos();
+    void setSourceSize(QSize);
+    void setSourceFlip(bool flipOn, int flipMode, QRect flipRect);
 private:
+    QPoint mapToSource(QPoint);
     MouseData mouseData;
     QPoint startPoint;
     QPoint mouseCursorPos;
     bool drawBox;
     QRect *box;
+    QSize sourceSize;
+    bool sourceFlipOn;
+    int sourceFlipMode;
+    QRect sourceFlipRect;
 protected:
     void mouseMoveEvent(QMouseEvent *ev);
     void mousePressEvent(QMouseEvent *ev);
     void mouseReleaseEvent(QMouseEvent *ev);
     void paintEvent(QPaintEvent *ev);
+    void resizeEvent(QResizeEvent *ev);
 signals:
     void newMouseData(struct MouseData mouseData);
     void onMouseMoveEvent();
+    void onMousePressEvent();
+    void onResizeEvent();
 };
 
 #endif // FRAMELABEL_H
@@ -0,0 +1,830 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* HaarCascade.cpp                                                      */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "HaarCascade.h"
+
+// Qt header files
+#include <QDebug>
+#include <QFileInfo>
+#include <QTemporaryFile>
+// OpenCV header files
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__GNUC__)&&(defined(__i386__)||defined(__x86_64__))
+#define HAAR_CASCADE_X86
+#include <immintrin.h>
+#endif
+
+// SIMD evaluators can be disabled at run time (e.g. to benchmark against the scalar evaluator)
+static bool simdEnabled=true;
+
+// Cascade data and integral images needed to evaluate windows of a stump-based cascade on one pyramid level
+struct HaarStumpContext{
+    const HaarCascadeHeader *header;
+    const HaarCascadeStage *stages;
+    const HaarCascadeTree *trees;
+    const HaarCascadeNode *nodes;
+    const float *leaves;
+    const HaarCascadeFeature *features;
+    const int *rectOffsets;
+    const int *sum;
+    const double *sqsum;
+    const int *tilted;
+    int sumStep;
+    int sqsumStep;
+};
+
+#ifdef HAAR_CASCADE_X86
+// Variance normalization factors of 4 windows (sqsum offsets of window origins, window sums)
+// (standard deviation of window interior, 1 if variance is negative: as by HaarCascade::runAt())
+__attribute__((target("avx2")))
+static inline __m256d varianceNormFactor4AVX2(const HaarStumpContext &c, __m128i sqsumOffsets, __m128i valsum)
+{
+    int nw=c.header->windowWidth-2;
+    int nh=c.header->windowHeight-2;
+    const double *q=c.sqsum+c.sqsumStep+1;
+    __m256d valsqsum=_mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(
+                                       _mm256_i32gather_pd(q,sqsumOffsets,8),
+                                       _mm256_i32gather_pd(q+nw,sqsumOffsets,8)),
+                                       _mm256_i32gather_pd(q+nh*c.sqsumStep,sqsumOffsets,8)),
+                                       _mm256_i32gather_pd(q+nh*c.sqsumStep+nw,sqsumOffsets,8));
+    __m256d invArea=_mm256_set1_pd(1./(nw*nh));
+    __m256d mean=_mm256_mul_pd(_mm256_cvtepi32_pd(valsum),invArea);
+    __m256d variance=_mm256_sub_pd(_mm256_mul_pd(valsqsum,invArea),_mm256_mul_pd(mean,mean));
+    return _mm256_blendv_pd(_mm256_set1_pd(1.),_mm256_sqrt_pd(variance),
+                            _mm256_cmp_pd(variance,_mm256_setzero_pd(),_CMP_GE_OQ));
+} // varianceNormFactor4AVX2()
+
+// Evaluates 8 windows of row y (x, x+step, ..., x+7*step): feature sums of all 8 windows are gathered at once,
+// a window stops contributing when a stage rejects it and evaluation ends when all 8 windows are rejected
+// (same arithmetic as HaarCascade::runAt(): rectangle products in float, sums and comparisons in double)
+__attribute__((target("avx2")))
+static void runStumpsAVX2(const HaarStumpContext &c, int x, int y, int step, int *results)
+{
+    __m256i lanes=_mm256_mullo_epi32(_mm256_setr_epi32(0,1,2,3,4,5,6,7),_mm256_set1_epi32(step));
+    __m256i sumOffsets=_mm256_add_epi32(_mm256_set1_epi32(y*c.sumStep+x),lanes);
+    __m256i sqsumOffsets=_mm256_add_epi32(_mm256_set1_epi32(y*c.sqsumStep+x),lanes);
+    // Variance normalization over window interior (1-pixel border excluded)
+    int nw=c.header->windowWidth-2;
+    int nh=c.header->windowHeight-2;
+    const int *s=c.sum+c.sumStep+1;
+    __m256i valsum=_mm256_add_epi32(_mm256_sub_epi32(_mm256_sub_epi32(
+                                        _mm256_i32gather_epi32(s,sumOffsets,4),
+                                        _mm256_i32gather_epi32(s+nw,sumOffsets,4)),
+                                        _mm256_i32gather_epi32(s+nh*c.sumStep,sumOffsets,4)),
+                                        _mm256_i32gather_epi32(s+nh*c.sumStep+nw,sumOffsets,4));
+    // Windows 0-3 (low) and 4-7 (high)
+    __m256d normLow=varianceNormFactor4AVX2(c,_mm256_castsi256_si128(sqsumOffsets),_mm256_castsi256_si128(valsum));
+    __m256d normHigh=varianceNormFactor4AVX2(c,_mm256_extracti128_si256(sqsumOffsets,1),_mm256_extracti128_si256(valsum,1));
+    int active=0xff;
+    for(int i=0;i<8;i++)
+        results[i]=1;
+    for(int si=0;si<c.header->nStages;si++)
+    {
+        const HaarCascadeStage &stage=c.stages[si];
+        __m256d stageSumLow=_mm256_setzero_pd();
+        __m256d stageSumHigh=_mm256_setzero_pd();
+        for(int ti=stage.firstTree;ti<stage.firstTree+stage.nTrees;ti++)
+        {
+            const HaarCascadeTree &tree=c.trees[ti];
+            const HaarCascadeNode &node=c.nodes[tree.firstNode];
+            const HaarCascadeFeature &feature=c.features[node.featureIdx];
+            const int *p=feature.tilted ? c.tilted : c.sum;
+            const int *o=&c.rectOffsets[node.featureIdx*HAAR_CASCADE_MAX_RECTS*4];
+            __m256d valueLow=_mm256_setzero_pd();
+            __m256d valueHigh=_mm256_setzero_pd();
+            for(int k=0;k<feature.nRects;k++,o+=4)
+            {
+                __m256i rectSum=_mm256_add_epi32(_mm256_sub_epi32(_mm256_sub_epi32(
+                                                     _mm256_i32gather_epi32(p+o[0],sumOffsets,4),
+                                                     _mm256_i32gather_epi32(p+o[1],sumOffsets,4)),
+                                                     _mm256_i32gather_epi32(p+o[2],sumOffsets,4)),
+                                                     _mm256_i32gather_epi32(p+o[3],sumOffsets,4));
+                __m256 product=_mm256_mul_ps(_mm256_cvtepi32_ps(rectSum),_mm256_set1_ps(feature.rect[k].weight));
+                valueLow=_mm256_add_pd(valueLow,_mm256_cvtps_pd(_mm256_castps256_ps128(product)));
+                valueHigh=_mm256_add_pd(valueHigh,_mm256_cvtps_pd(_mm256_extractf128_ps(product,1)));
+            }
+            __m256d threshold=_mm256_set1_pd((double)node.threshold);
+            __m256d leftLeaf=_mm256_set1_pd((double)c.leaves[tree.firstLeaf-node.left]);
+            __m256d rightLeaf=_mm256_set1_pd((double)c.leaves[tree.firstLeaf-node.right]);
+            stageSumLow=_mm256_add_pd(stageSumLow,_mm256_blendv_pd(rightLeaf,leftLeaf,
+                                      _mm256_cmp_pd(valueLow,_mm256_mul_pd(threshold,normLow),_CMP_LT_OQ)));
+            stageSumHigh=_mm256_add_pd(stageSumHigh,_mm256_blendv_pd(rightLeaf,leftLeaf,
+                                       _mm256_cmp_pd(valueHigh,_mm256_mul_pd(threshold,normHigh),_CMP_LT_OQ)));
+        }
+        // Windows rejected by this stage: 0 if rejected by first stage, negative stage index if rejected by a later stage
+        __m256d stageThreshold=_mm256_set1_pd((double)stage.threshold-HAAR_CASCADE_STAGE_THRESHOLD_BIAS);
+        int passed=_mm256_movemask_pd(_mm256_cmp_pd(stageSumLow,stageThreshold,_CMP_GE_OQ))|
+                   (_mm256_movemask_pd(_mm256_cmp_pd(stageSumHigh,stageThreshold,_CMP_GE_OQ))<<4);
+        for(int i=0;i<8;i++)
+            if((active&~passed)&(1<<i))
+                results[i]=-si;
+        active&=passed;
+        if(active==0)
+            break;
+    }
+} // runStumpsAVX2()
+
+// Loads integral image values at 4 offsets
+__attribute__((target("sse2")))
+static inline __m128i gather4SSE2(const int *p, const int *offsets)
+{
+    return _mm_setr_epi32(p[offsets[0]],p[offsets[1]],p[offsets[2]],p[offsets[3]]);
+} // gather4SSE2()
+
+// Selects a where mask is set, else b
+__attribute__((target("sse2")))
+static inline __m128d select2SSE2(__m128d mask, __m128d a, __m128d b)
+{
+    return _mm_or_pd(_mm_and_pd(mask,a),_mm_andnot_pd(mask,b));
+} // select2SSE2()
+
+// Evaluates 4 windows of row y (x, x+step, x+2*step, x+3*step): as runStumpsAVX2() (without gather instructions)
+__attribute__((target("sse2")))
+static void runStumpsSSE2(const HaarStumpContext &c, int x, int y, int step, int *results)
+{
+    int sumOffsets[4];
+    double norm[4];
+    // Variance normalization over window interior (1-pixel border excluded)
+    int nw=c.header->windowWidth-2;
+    int nh=c.header->windowHeight-2;
+    double invArea=1./(nw*nh);
+    for(int i=0;i<4;i++)
+    {
+        sumOffsets[i]=y*c.sumStep+x+i*step;
+        const int *s=c.sum+(y+1)*c.sumStep+(x+i*step+1);
+        const double *q=c.sqsum+(y+1)*c.sqsumStep+(x+i*step+1);
+        int valsum=s[0]-s[nw]-s[nh*c.sumStep]+s[nh*c.sumStep+nw];
+        double valsqsum=q[0]-q[nw]-q[nh*c.sqsumStep]+q[nh*c.sqsumStep+nw];
+        double mean=valsum*invArea;
+        double variance=valsqsum*invArea-mean*mean;
+        norm[i]=(variance>=0.) ? std::sqrt(variance) : 1.;
+    }
+    // Windows 0-1 (low) and 2-3 (high)
+    __m128d normLow=_mm_loadu_pd(&norm[0]);
+    __m128d normHigh=_mm_loadu_pd(&norm[2]);
+    int active=0xf;
+    for(int i=0;i<4;i++)
+        results[i]=1;
+    for(int si=0;si<c.header->nStages;si++)
+    {
+        const HaarCascadeStage &stage=c.stages[si];
+        __m128d stageSumLow=_mm_setzero_pd();
+        __m128d stageSumHigh=_mm_setzero_pd();
+        for(int ti=stage.firstTree;ti<stage.firstTree+stage.nTrees;ti++)
+        {
+            const HaarCascadeTree &tree=c.trees[ti];
+            const HaarCascadeNode &node=c.nodes[tree.firstNode];
+            const HaarCascadeFeature &feature=c.features[node.featureIdx];
+            const int *p=feature.tilted ? c.tilted : c.sum;
+            const int *o=&c.rectOffsets[node.featureIdx*HAAR_CASCADE_MAX_RECTS*4];
+            __m128d valueLow=_mm_setzero_pd();
+            __m128d valueHigh=_mm_setzero_pd();
+            for(int k=0;k<feature.nRects;k++,o+=4)
+            {
+                __m128i rectSum=_mm_add_epi32(_mm_sub_epi32(_mm_sub_epi32(
+                                                  gather4SSE2(p+o[0],sumOffsets),
+                                                  gather4SSE2(p+o[1],sumOffsets)),
+                                                  gather4SSE2(p+o[2],sumOffsets)),
+                                                  gather4SSE2(p+o[3],sumOffsets));
+                __m128 product=_mm_mul_ps(_mm_cvtepi32_ps(rectSum),_mm_set1_ps(feature.rect[k].weight));
+                valueLow=_mm_add_pd(valueLow,_mm_cvtps_pd(product));
+                valueHigh=_mm_add_pd(valueHigh,_mm_cvtps_pd(_mm_movehl_ps(product,product)));
+            }
+            __m128d threshold=_mm_set1_pd((double)node.threshold);
+            __m128d leftLeaf=_mm_set1_pd((double)c.leaves[tree.firstLeaf-node.left]);
+            __m128d rightLeaf=_mm_set1_pd((double)c.leaves[tree.firstLeaf-node.right]);
+            stageSumLow=_mm_add_pd(stageSumLow,select2SSE2(_mm_cmplt_pd(valueLow,_mm_mul_pd(threshold,normLow)),leftLeaf,rightLeaf));
+            stageSumHigh=_mm_add_pd(stageSumHigh,select2SSE2(_mm_cmplt_pd(valueHigh,_mm_mul_pd(threshold,normHigh)),leftLeaf,rightLeaf));
+        }
+        // Windows rejected by this stage: 0 if rejected by first stage, negative stage index if rejected by a later stage
+        __m128d stageThreshold=_mm_set1_pd((double)stage.threshold-HAAR_CASCADE_STAGE_THRESHOLD_BIAS);
+        int passed=_mm_movemask_pd(_mm_cmpge_pd(stageSumLow,stageThreshold))|
+                   (_mm_movemask_pd(_mm_cmpge_pd(stageSumHigh,stageThreshold))<<2);
+        for(int i=0;i<4;i++)
+            if((active&~passed)&(1<<i))
+                results[i]=-si;
+        active&=passed;
+        if(active==0)
+            break;
+    }
+} // runStumpsSSE2()
+#endif
+
+HaarCascade::HaarCascade()
+{
+    // Initialize variables
+    header=NULL;
+    stages=NULL;
+    trees=NULL;
+    nodes=NULL;
+    leaves=NULL;
+    features=NULL;
+    stumpBased=false;
+} // HaarCascade constructor
+
+HaarCascade::~HaarCascade()
+{
+    close();
+} // HaarCascade destructor
+
+bool HaarCascade::load(const QString &filename)
+{
+    // Local variables
+    qint64 size, expectedSize;
+    const uchar *data;
+    // Close previously loaded cascade (if it exists)
+    close();
+    file.setFileName(filename);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+    size=file.size();
+    if(size<(qint64)sizeof(HaarCascadeHeader))
+    {
+        qDebug() << "ERROR: Binary cascade file truncated:" << filename;
+        close();
+        return false;
+    }
+    // Map file into memory: cascade is used in place (no parsing)
+    data=file.map(0,size);
+    if(data==NULL)
+    {
+        qDebug() << "ERROR: Binary cascade file could not be mapped:" << filename;
+        close();
+        return false;
+    }
+    header=(const HaarCascadeHeader*)data;
+    // Check magic, version and size of sections
+    if((header->nStages<0)||(header->nTrees<0)||(header->nNodes<0)||(header->nLeaves<0)||(header->nFeatures<0))
+    {
+        qDebug() << "ERROR: Invalid binary cascade file:" << filename;
+        close();
+        return false;
+    }
+    expectedSize=(qint64)sizeof(HaarCascadeHeader)+
+                 (qint64)header->nStages*sizeof(HaarCascadeStage)+
+                 (qint64)header->nTrees*sizeof(HaarCascadeTree)+
+                 (qint64)header->nNodes*sizeof(HaarCascadeNode)+
+                 (qint64)header->nLeaves*sizeof(float)+
+                 (qint64)header->nFeatures*sizeof(HaarCascadeFeature);
+    if((memcmp(header->magic,HAAR_CASCADE_MAGIC,sizeof(header->magic))!=0)||
+       (header->version!=HAAR_CASCADE_VERSION)||(size!=expectedSize))
+    {
+        qDebug() << "ERROR: Invalid binary cascade file:" << filename;
+        close();
+        return false;
+    }
+    // Set section pointers
+    stages=(const HaarCascadeStage*)(data+sizeof(HaarCascadeHeader));
+    trees=(const HaarCascadeTree*)(stages+header->nStages);
+    nodes=(const HaarCascadeNode*)(trees+header->nTrees);
+    leaves=(const float*)(nodes+header->nNodes);
+    features=(const HaarCascadeFeature*)(leaves+header->nLeaves);
+    // Indices are used without checks by evaluators: reject file if any index is out of range
+    if(!validate())
+    {
+        qDebug() << "ERROR: Invalid binary cascade file:" << filename;
+        close();
+        return false;
+    }
+    // Stump-based cascade: every tree is a single node (windows can be evaluated with SIMD evaluators)
+    stumpBased=true;
+    for(int i=0;(i<header->nTrees)&&stumpBased;i++)
+    {
+        int nTreeNodes=((i+1<header->nTrees) ? trees[i+1].firstNode : header->nNodes)-trees[i].firstNode;
+        if((nTreeNodes!=1)||(nodes[trees[i].firstNode].left>0)||(nodes[trees[i].firstNode].right>0))
+            stumpBased=false;
+    }
+    return true;
+} // load()
+
+bool HaarCascade::validate()
+{
+    // Window interior (1-pixel border excluded) must not be empty
+    if((header->windowWidth<3)||(header->windowHeight<3))
+        return false;
+    // Stages: trees in range
+    for(int i=0;i<header->nStages;i++)
+    {
+        const HaarCascadeStage &stage=stages[i];
+        if((stage.firstTree<0)||(stage.nTrees<0)||((qint64)stage.firstTree+stage.nTrees>header->nTrees))
+            return false;
+    }
+    // Trees: nodes and leaves of tree i are [firstNode,next firstNode) and [firstLeaf,next firstLeaf)
+    for(int i=0;i<header->nTrees;i++)
+    {
+        const HaarCascadeTree &tree=trees[i];
+        int endNode=(i+1<header->nTrees) ? trees[i+1].firstNode : header->nNodes;
+        int endLeaf=(i+1<header->nTrees) ? trees[i+1].firstLeaf : header->nLeaves;
+        if((tree.firstNode<0)||(tree.firstNode>=endNode)||(endNode>header->nNodes)||
+           (tree.firstLeaf<0)||(tree.firstLeaf>=endLeaf)||(endLeaf>header->nLeaves))
+            return false;
+        for(int n=0;n<endNode-tree.firstNode;n++)
+        {
+            const HaarCascadeNode &node=nodes[tree.firstNode+n];
+            if((node.featureIdx<0)||(node.featureIdx>=header->nFeatures))
+                return false;
+            // Child nodes follow their parent (tree evaluation always terminates), leaves belong to tree
+            const qint32 children[2]={node.left,node.right};
+            for(int c=0;c<2;c++)
+            {
+                if((children[c]>0)&&((children[c]<=n)||(children[c]>=endNode-tree.firstNode)))
+                    return false;
+                if((children[c]<=0)&&(-(qint64)children[c]>=endLeaf-tree.firstLeaf))
+                    return false;
+            }
+        }
+    }
+    // Features: rectangles inside window (tilted integral image is only computed if cascade has tilted features)
+    for(int i=0;i<header->nFeatures;i++)
+    {
+        const HaarCascadeFeature &feature=features[i];
+        if((feature.nRects<1)||(feature.nRects>HAAR_CASCADE_MAX_RECTS))
+            return false;
+        if(feature.tilted&&!header->hasTiltedFeatures)
+            return false;
+        for(int k=0;k<feature.nRects;k++)
+        {
+            qint64 x=feature.rect[k].x;
+            qint64 y=feature.rect[k].y;
+            qint64 width=feature.rect[k].width;
+            qint64 height=feature.rect[k].height;
+            if((width<0)||(height<0))
+                return false;
+            if(feature.tilted ? ((x-height<0)||(y<0)||(x+width>header->windowWidth)||
+                                 (y+width+height>header->windowHeight))
+                              : ((x<0)||(y<0)||(x+width>header->windowWidth)||
+                                 (y+height>header->windowHeight)))
+                return false;
+        }
+    }
+    return true;
+} // validate()
+
+void HaarCascade::close()
+{
+    // Unmap and close file (if open)
+    if(file.isOpen())
+    {
+        if(header!=NULL)
+            file.unmap((uchar*)header);
+        file.close();
+    }
+    header=NULL;
+    stages=NULL;
+    trees=NULL;
+    nodes=NULL;
+    leaves=NULL;
+    features=NULL;
+    stumpBased=false;
+} // close()
+
+bool HaarCascade::empty()
+{
+    return header==NULL;
+} // empty()
+
+cv::Size HaarCascade::getWindowSize()
+{
+    if(header==NULL)
+        return cv::Size();
+    return cv::Size(header->windowWidth,header->windowHeight);
+} // getWindowSize()
+
+bool HaarCascade::hasTiltedFeatures()
+{
+    return (header!=NULL)&&(header->hasTiltedFeatures!=0);
+} // hasTiltedFeatures()
+
+bool HaarCascade::isStumpBased()
+{
+    return (header!=NULL)&&stumpBased;
+} // isStumpBased()
+
+int HaarCascade::getSimdLevel()
+{
+    if(!simdEnabled)
+        return HAAR_CASCADE_SIMD_NONE;
+#ifdef HAAR_CASCADE_X86
+    // CPU features are checked once
+    static int simdLevel=__builtin_cpu_supports("avx2") ? HAAR_CASCADE_SIMD_AVX2 :
+                         (__builtin_cpu_supports("sse2") ? HAAR_CASCADE_SIMD_SSE2 : HAAR_CASCADE_SIMD_NONE);
+    return simdLevel;
+#else
+    return HAAR_CASCADE_SIMD_NONE;
+#endif
+} // getSimdLevel()
+
+void HaarCascade::setSimdEnabled(bool enabled)
+{
+    // Not synchronized: must not be called while detection is running
+    simdEnabled=enabled;
+} // setSimdEnabled()
+
+void HaarCascade::computeRectOffsets(int step, std::vector<int> &rectOffsets)
+{
+    // Offsets of the 4 integral image corners of each feature rectangle (relative to window origin)
+    rectOffsets.assign(header->nFeatures*HAAR_CASCADE_MAX_RECTS*4,0);
+    for(int i=0;i<header->nFeatures;i++)
+    {
+        const HaarCascadeFeature &feature=features[i];
+        for(int k=0;k<feature.nRects;k++)
+        {
+            const HaarCascadeRect &r=feature.rect[k];
+            int *o=&rectOffsets[(i*HAAR_CASCADE_MAX_RECTS+k)*4];
+            if(feature.tilted)
+            {
+                o[0]=r.x+step*r.y;
+                o[1]=r.x-r.height+step*(r.y+r.height);
+                o[2]=r.x+r.width+step*(r.y+r.width);
+                o[3]=r.x+r.width-r.height+step*(r.y+r.width+r.height);
+            }
+            else
+            {
+                o[0]=r.x+step*r.y;
+                o[1]=r.x+r.width+step*r.y;
+                o[2]=r.x+step*(r.y+r.height);
+                o[3]=r.x+r.width+step*(r.y+r.height);
+            }
+        }
+    }
+} // computeRectOffsets()
+
+int HaarCascade::runAt(const int *sum, const double *sqsum, const int *tilted, int sumStep, int sqsumStep,
+                       const std::vector<int> &rectOffsets, int x, int y)
+{
+    // Variance normalization over window interior (1-pixel border excluded)
+    int nw=header->windowWidth-2;
+    int nh=header->windowHeight-2;
+    const int *s=sum+(y+1)*sumStep+(x+1);
+    const double *q=sqsum+(y+1)*sqsumStep+(x+1);
+    int valsum=s[0]-s[nw]-s[nh*sumStep]+s[nh*sumStep+nw];
+    double valsqsum=q[0]-q[nw]-q[nh*sqsumStep]+q[nh*sqsumStep+nw];
+    // Standard deviation of window interior (1 if variance is negative): node thresholds are scaled by it
+    // (same arithmetic as OpenCV evaluator of old-format cascades)
+    double invArea=1./(nw*nh);
+    double mean=valsum*invArea;
+    double variance=valsqsum*invArea-mean*mean;
+    double norm=(variance>=0.) ? std::sqrt(variance) : 1.;
+    int offset=y*sumStep+x;
+    // Evaluate stages (window is rejected as soon as one stage fails)
+    for(int si=0;si<header->nStages;si++)
+    {
+        const HaarCascadeStage &stage=stages[si];
+        double stageSum=0.;
+        for(int ti=stage.firstTree;ti<stage.firstTree+stage.nTrees;ti++)
+        {
+            const HaarCascadeTree &tree=trees[ti];
+            int idx=0;
+            do
+            {
+                const HaarCascadeNode &node=nodes[tree.firstNode+idx];
+                const HaarCascadeFeature &feature=features[node.featureIdx];
+                const int *p=(feature.tilted ? tilted : sum)+offset;
+                const int *o=&rectOffsets[node.featureIdx*HAAR_CASCADE_MAX_RECTS*4];
+                double value=0.;
+                for(int k=0;k<feature.nRects;k++,o+=4)
+                    value+=feature.rect[k].weight*(p[o[0]]-p[o[1]]-p[o[2]]+p[o[3]]);
+                idx=(value<node.threshold*norm) ? node.left : node.right;
+            } while(idx>0);
+            stageSum+=leaves[tree.firstLeaf-idx];
+        }
+        // Returns 0 if rejected by first stage, negative stage index if rejected by a later stage
+        if(stageSum<stage.threshold-HAAR_CASCADE_STAGE_THRESHOLD_BIAS)
+            return -si;
+    }
+    return 1;
+} // runAt()
+
+void HaarCascade::detectMultiScale(const cv::Mat &image, std::vector<cv::Rect> &objects,
+                                   double scaleFactor, int minNeighbors,
+                                   cv::Size minSize, cv::Size maxSize)
+{
+    // Local variables
+    HaarPyramidLevel level;
+    objects.clear();
+    if(empty()||image.empty())
+        return;
+    CV_Assert(image.type()==CV_8UC1);
+    cv::Size windowSize=getWindowSize();
+    if((maxSize.width<=0)||(maxSize.height<=0))
+        maxSize=image.size();
+    // Image is scaled down (window size is fixed), as with CV_HAAR_SCALE_IMAGE
+    for(double factor=1.;;factor*=scaleFactor)
+    {
+        cv::Size scaledWindowSize(cvRound(windowSize.width*factor),cvRound(windowSize.height*factor));
+        cv::Size scaledImageSize(cvRound(image.cols/factor),cvRound(image.rows/factor));
+        if((scaledImageSize.width<=windowSize.width)||(scaledImageSize.height<=windowSize.height))
+            break;
+        if((scaledWindowSize.width>maxSize.width)||(scaledWindowSize.height>maxSize.height))
+            break;
+        if((scaledWindowSize.width<minSize.width)||(scaledWindowSize.height<minSize.height))
+            continue;
+        computeLevel(image,factor,hasTiltedFeatures(),level);
+        detectAtLevel(level,minSize,maxSize,objects);
+    }
+    // Merge overlapping detections
+    cv::groupRectangles(objects,minNeighbors,0.2);
+} // detectMultiScale()
+
+void HaarCascade::computeLevel(const cv::Mat &image, double factor, bool tilted, HaarPyramidLevel &level)
+{
+    level.factor=factor;
+    if(factor==1.)
+        level.image=image;
+    else
+    {
+        // Do not resize into the source image (level may previously have referenced it)
+        if(level.image.data==image.data)
+            level.image=cv::Mat();
+        cv::resize(image,level.image,cv::Size(cvRound(image.cols/factor),cvRound(image.rows/factor)),0,0,cv::INTER_LINEAR);
+    }
+    // Integral images (tilted integral only if required by a cascade using this level)
+    if(tilted)
+        cv::integral(level.image,level.sum,level.sqsum,level.tilted);
+    else
+    {
+        cv::integral(level.image,level.sum,level.sqsum);
+        level.tilted.release();
+    }
+} // computeLevel()
+
+void HaarCascade::detectAtLevel(const HaarPyramidLevel &level, cv::Size minSize, cv::Size maxSize,
+                                std::vector<cv::Rect> &candidates, int yBegin, int yEnd)
+{
+    // Called concurrently for different levels/cascades/rows: cascade data is read-only, candidates are appended (not grouped)
+    std::vector<int> rectOffsets;
+    std::vector<int> rowResults;
+    HaarStumpContext context;
+    if(empty())
+        return;
+    cv::Size windowSize=getWindowSize();
+    cv::Size scaledWindowSize(cvRound(windowSize.width*level.factor),cvRound(windowSize.height*level.factor));
+    // Level too small for window, window outside object size range or tilted integral missing
+    if((level.image.cols<=windowSize.width)||(level.image.rows<=windowSize.height))
+        return;
+    if((scaledWindowSize.width<minSize.width)||(scaledWindowSize.height<minSize.height))
+        return;
+    if((maxSize.width>0)&&(maxSize.height>0)&&
+       ((scaledWindowSize.width>maxSize.width)||(scaledWindowSize.height>maxSize.height)))
+        return;
+    if(hasTiltedFeatures()&&level.tilted.empty())
+        return;
+    int sumStep=(int)(level.sum.step/sizeof(int));
+    int sqsumStep=(int)(level.sqsum.step/sizeof(double));
+    computeRectOffsets(sumStep,rectOffsets);
+    // Scan windows (coarser step at small scales; skip neighbour of windows rejected by first stage)
+    int step=(level.factor>2.) ? 1 : 2;
+    // Rows [yBegin,yEnd) of window origins (whole level by default)
+    if((yEnd<0)||(yEnd>level.image.rows-windowSize.height))
+        yEnd=level.image.rows-windowSize.height;
+    yBegin=((yBegin+step-1)/step)*step;
+    int simdLevel=stumpBased ? getSimdLevel() : HAAR_CASCADE_SIMD_NONE;
+    if(simdLevel==HAAR_CASCADE_SIMD_NONE)
+    {
+        for(int y=yBegin;y<yEnd;y+=step)
+        {
+            for(int x=0;x+windowSize.width<level.image.cols;x+=step)
+            {
+                int result=runAt((const int*)level.sum.data,(const double*)level.sqsum.data,
+                                 hasTiltedFeatures() ? (const int*)level.tilted.data : NULL,
+                                 sumStep,sqsumStep,rectOffsets,x,y);
+                if(result>0)
+                    candidates.push_back(cv::Rect(cvRound(x*level.factor),cvRound(y*level.factor),
+                                                  scaledWindowSize.width,scaledWindowSize.height));
+                else if(result==0)
+                    x+=step;
+            }
+        }
+        return;
+    }
+#ifdef HAAR_CASCADE_X86
+    context.header=header;
+    context.stages=stages;
+    context.trees=trees;
+    context.nodes=nodes;
+    context.leaves=leaves;
+    context.features=features;
+    context.rectOffsets=&rectOffsets[0];
+    context.sum=(const int*)level.sum.data;
+    context.sqsum=(const double*)level.sqsum.data;
+    context.tilted=hasTiltedFeatures() ? (const int*)level.tilted.data : NULL;
+    context.sumStep=sumStep;
+    context.sqsumStep=sqsumStep;
+    int nWindows=(level.image.cols-windowSize.width+step-1)/step;
+    rowResults.resize(nWindows);
+    for(int y=yBegin;y<yEnd;y+=step)
+    {
+        // Evaluate all windows of row: 8 (AVX2) or 4 (SSE2) windows at a time, remaining windows one at a time
+        int i=0;
+        if(simdLevel==HAAR_CASCADE_SIMD_AVX2)
+            for(;i+8<=nWindows;i+=8)
+                runStumpsAVX2(context,i*step,y,step,&rowResults[i]);
+        for(;i+4<=nWindows;i+=4)
+            runStumpsSSE2(context,i*step,y,step,&rowResults[i]);
+        for(;i<nWindows;i++)
+            rowResults[i]=runAt(context.sum,context.sqsum,context.tilted,sumStep,sqsumStep,rectOffsets,i*step,y);
+        // Same windows are reported as by scalar scan (neighbour of window rejected by first stage is skipped)
+        for(i=0;i<nWindows;i++)
+        {
+            if(rowResults[i]>0)
+                candidates.push_back(cv::Rect(cvRound(i*step*level.factor),cvRound(y*level.factor),
+                                              scaledWindowSize.width,scaledWindowSize.height));
+            else if(rowResults[i]==0)
+                i++;
+        }
+    }
+#endif
+} // detectAtLevel()
+
+QString HaarCascade::binaryFilename(const QString &xmlFilename)
+{
+    // Binary cascade is stored next to XML cascade: <name>.bin
+    QFileInfo fileInfo(xmlFilename);
+    return fileInfo.path()+QString("/")+fileInfo.completeBaseName()+QString(".bin");
+} // binaryFilename()
+
+bool HaarCascade::compile(const QString &xmlFilename, const QString &binaryFilename)
+{
+    // Local variables
+    HaarCascadeHeader newHeader;
+    std::vector<HaarCascadeStage> newStages;
+    std::vector<HaarCascadeTree> newTrees;
+    std::vector<HaarCascadeNode> newNodes;
+    std::vector<float> newLeaves;
+    std::vector<HaarCascadeFeature> newFeatures;
+    // Open XML cascade (old "opencv-haar-classifier" format)
+    cv::FileStorage fs(xmlFilename.toUtf8().constData(),cv::FileStorage::READ);
+    if(!fs.isOpened())
+    {
+        qDebug() << "ERROR: Can not open cascade file:" << xmlFilename;
+        return false;
+    }
+    cv::FileNode root=fs.getFirstTopLevelNode();
+    cv::FileNode sizeNode=root["size"];
+    cv::FileNode stagesNode=root["stages"];
+    if((sizeNode.size()!=2)||stagesNode.empty())
+    {
+        qDebug() << "ERROR: Unsupported cascade file format:" << xmlFilename;
+        return false;
+    }
+    memset(&newHeader,0,sizeof(newHeader));
+    memcpy(newHeader.magic,HAAR_CASCADE_MAGIC,sizeof(newHeader.magic));
+    newHeader.version=HAAR_CASCADE_VERSION;
+    newHeader.windowWidth=(int)sizeNode[0];
+    newHeader.windowHeight=(int)sizeNode[1];
+    if((newHeader.windowWidth<3)||(newHeader.windowHeight<3))
+    {
+        qDebug() << "ERROR: Unsupported cascade window size:" << xmlFilename;
+        return false;
+    }
+    // Rectangle weights are normalized by area of window interior (1-pixel border excluded)
+    double weightScale=1./((newHeader.windowWidth-2)*(newHeader.windowHeight-2));
+    // Stages
+    int stageIdx=0;
+    for(cv::FileNodeIterator si=stagesNode.begin();si!=stagesNode.end();++si,stageIdx++)
+    {
+        cv::FileNode stageNode=*si;
+        // Only sequential cascades are supported (tree-structured cascades link stages via parent/next)
+        if((!stageNode["parent"].empty()&&((int)stageNode["parent"]!=stageIdx-1))||
+           (!stageNode["next"].empty()&&((int)stageNode["next"]!=-1)))
+        {
+            qDebug() << "ERROR: Tree-structured cascades cannot be compiled:" << xmlFilename;
+            return false;
+        }
+        HaarCascadeStage stage;
+        stage.firstTree=(int)newTrees.size();
+        stage.threshold=(float)stageNode["stage_threshold"];
+        // Trees
+        cv::FileNode treesNode=stageNode["trees"];
+        for(cv::FileNodeIterator ti=treesNode.begin();ti!=treesNode.end();++ti)
+        {
+            cv::FileNode treeNode=*ti;
+            HaarCascadeTree tree;
+            tree.firstNode=(int)newNodes.size();
+            tree.firstLeaf=(int)newLeaves.size();
+            int nTreeLeaves=0;
+            // Nodes
+            for(cv::FileNodeIterator ni=treeNode.begin();ni!=treeNode.end();++ni)
+            {
+                cv::FileNode nodeNode=*ni;
+                cv::FileNode featureNode=nodeNode["feature"];
+                cv::FileNode rectsNode=featureNode["rects"];
+                if((rectsNode.size()==0)||(rectsNode.size()>HAAR_CASCADE_MAX_RECTS))
+                {
+                    qDebug() << "ERROR: Unsupported number of feature rectangles:" << xmlFilename;
+                    return false;
+                }
+                HaarCascadeFeature feature;
+                memset(&feature,0,sizeof(feature));
+                feature.tilted=(int)featureNode["tilted"];
+                for(cv::FileNodeIterator ri=rectsNode.begin();ri!=rectsNode.end();++ri)
+                {
+                    cv::FileNode rectNode=*ri;
+                    HaarCascadeRect &r=feature.rect[feature.nRects++];
+                    r.x=(int)rectNode[0];
+                    r.y=(int)rectNode[1];
+                    r.width=(int)rectNode[2];
+                    r.height=(int)rectNode[3];
+                    // Tilted rectangles are weighted by 0.5 (as by OpenCV evaluator of old-format cascades)
+                    r.weight=(float)((float)rectNode[4]*(weightScale*(feature.tilted ? 0.5 : 1.)));
+                }
+                // Weight of first rectangle balances the other rectangles (as by OpenCV evaluator of old-format cascades)
+                double sum0=0.;
+                for(int k=1;k<feature.nRects;k++)
+                    sum0+=feature.rect[k].weight*feature.rect[k].width*feature.rect[k].height;
+                feature.rect[0].weight=(float)(-sum0/((double)feature.rect[0].width*feature.rect[0].height));
+                if(feature.tilted)
+                    newHeader.hasTiltedFeatures=1;
+                HaarCascadeNode node;
+                node.featureIdx=(int)newFeatures.size();
+                node.threshold=(float)nodeNode["threshold"];
+                // Child nodes are referenced by index in tree, leaf values are appended to tree leaves
+                if(!nodeNode["left_node"].empty())
+                    node.left=(int)nodeNode["left_node"];
+                else
+                {
+                    newLeaves.push_back((float)nodeNode["left_val"]);
+                    node.left=-(nTreeLeaves++);
+                }
+                if(!nodeNode["right_node"].empty())
+                    node.right=(int)nodeNode["right_node"];
+                else
+                {
+                    newLeaves.push_back((float)nodeNode["right_val"]);
+                    node.right=-(nTreeLeaves++);
+                }
+                newFeatures.push_back(feature);
+                newNodes.push_back(node);
+            }
+            newTrees.push_back(tree);
+        }
+        stage.nTrees=(int)newTrees.size()-stage.firstTree;
+        newStages.push_back(stage);
+    }
+    newHeader.nStages=(int)newStages.size();
+    newHeader.nTrees=(int)newTrees.size();
+    newHeader.nNodes=(int)newNodes.size();
+    newHeader.nLeaves=(int)newLeaves.size();
+    newHeader.nFeatures=(int)newFeatures.size();
+    // Write binary cascade to new temporary file (created exclusively) and rename it: an existing binary cascade
+    // is replaced atomically (file mapped by another process is not modified, symbolic link is not followed)
+    QTemporaryFile out(binaryFilename+QString(".XXXXXX"));
+    out.setAutoRemove(false);
+    if(!out.open())
+    {
+        qDebug() << "ERROR: Can not write binary cascade file:" << binaryFilename;
+        return false;
+    }
+    bool written=(out.write((const char*)&newHeader,sizeof(newHeader))==(qint64)sizeof(newHeader));
+    written=written&&(out.write((const char*)&newStages[0],newStages.size()*sizeof(HaarCascadeStage))==(qint64)(newStages.size()*sizeof(HaarCascadeStage)));
+    written=written&&(out.write((const char*)&newTrees[0],newTrees.size()*sizeof(HaarCascadeTree))==(qint64)(newTrees.size()*sizeof(HaarCascadeTree)));
+    written=written&&(out.write((const char*)&newNodes[0],newNodes.size()*sizeof(HaarCascadeNode))==(qint64)(newNodes.size()*sizeof(HaarCascadeNode)));
+    written=written&&(out.write((const char*)&newLeaves[0],newLeaves.size()*sizeof(float))==(qint64)(newLeaves.size()*sizeof(float)));
+    written=written&&(out.write((const char*)&newFeatures[0],newFeatures.size()*sizeof(HaarCascadeFeature))==(qint64)(newFeatures.size()*sizeof(HaarCascadeFeature)));
+    QString temporaryFilename=out.fileName();
+    out.close();
+    if(!written||(std::rename(QFile::encodeName(temporaryFilename).constData(),QFile::encodeName(binaryFilename).constData())!=0))
+    {
+        qDebug() << "ERROR: Can not write binary cascade file:" << binaryFilename;
+        QFile::remove(temporaryFilename);
+        return false;
+    }
+    return true;
+} // compile()
@@ -0,0 +1,158 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* HaarCascade.h                                                        */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef HAARCASCADE_H
+#define HAARCASCADE_H
+
+// Qt header files
+#include <QtCore>
+// OpenCV header files
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+// Binary cascade file format (all sections are arrays of the structures below, in this order):
+// [header][stages][trees][nodes][leaves (float)][features]
+#define HAAR_CASCADE_MAGIC "QOCVHAAR"
+#define HAAR_CASCADE_VERSION 4
+#define HAAR_CASCADE_MAX_RECTS 3
+// Stage sums are compared with stage thresholds lowered by this value
+// (as by OpenCV evaluator of old-format cascades, used by cv::CascadeClassifier for these cascades)
+#define HAAR_CASCADE_STAGE_THRESHOLD_BIAS 1e-4
+
+// Window evaluators (SIMD evaluators are used for stump-based cascades if supported by the CPU)
+#define HAAR_CASCADE_SIMD_NONE 0
+#define HAAR_CASCADE_SIMD_SSE2 1
+#define HAAR_CASCADE_SIMD_AVX2 2
+
+// HaarCascadeHeader structure definition
+struct HaarCascadeHeader{
+    char magic[8];
+    qint32 version;
+    qint32 windowWidth;
+    qint32 windowHeight;
+    qint32 hasTiltedFeatures;
+    qint32 nStages;
+    qint32 nTrees;
+    qint32 nNodes;
+    qint32 nLeaves;
+    qint32 nFeatures;
+};
+
+// HaarCascadeStage structure definition
+struct HaarCascadeStage{
+    qint32 firstTree;
+    qint32 nTrees;
+    float threshold;
+};
+
+// HaarCascadeTree structure definition
+struct HaarCascadeTree{
+    qint32 firstNode;
+    qint32 firstLeaf;
+};
+
+// HaarCascadeNode structure definition
+// (left/right: index of child node in tree if >0, else -(index of leaf in tree))
+struct HaarCascadeNode{
+    qint32 featureIdx;
+    float threshold;
+    qint32 left;
+    qint32 right;
+};
+
+// HaarCascadeRect structure definition
+struct HaarCascadeRect{
+    qint32 x;
+    qint32 y;
+    qint32 width;
+    qint32 height;
+    float weight;
+};
+
+// HaarCascadeFeature structure definition
+struct HaarCascadeFeature{
+    qint32 tilted;
+    qint32 nRects;
+    HaarCascadeRect rect[HAAR_CASCADE_MAX_RECTS];
+};
+
+// HaarPyramidLevel structure definition
+// (scaled image with its integral images: may be shared by several cascades)
+struct HaarPyramidLevel{
+    double factor;
+    cv::Mat image;
+    cv::Mat sum;
+    cv::Mat sqsum;
+    cv::Mat tilted;
+};
+
+class HaarCascade
+{
+
+public:
+    HaarCascade();
+    ~HaarCascade();
+    bool load(const QString &filename);
+    bool empty();
+    cv::Size getWindowSize();
+    bool hasTiltedFeatures();
+    bool isStumpBased();
+    void detectMultiScale(const cv::Mat &image, std::vector<cv::Rect> &objects,
+                          double scaleFactor, int minNeighbors,
+                          cv::Size minSize, cv::Size maxSize=cv::Size());
+    void detectAtLevel(const HaarPyramidLevel &level, cv::Size minSize, cv::Size maxSize,
+                       std::vector<cv::Rect> &candidates, int yBegin=0, int yEnd=-1);
+    static void computeLevel(const cv::Mat &image, double factor, bool tilted, HaarPyramidLevel &level);
+    static bool compile(const QString &xmlFilename, const QString &binaryFilename);
+    static QString binaryFilename(const QString &xmlFilename);
+    static int getSimdLevel();
+    static void setSimdEnabled(bool enabled);
+private:
+    void close();
+    bool validate();
+    void computeRectOffsets(int step, std::vector<int> &rectOffsets);
+    int runAt(const int *sum, const double *sqsum, const int *tilted, int sumStep, int sqsumStep,
+              const std::vector<int> &rectOffsets, int x, int y);
+    QFile file;
+    const HaarCascadeHeader *header;
+    const HaarCascadeStage *stages;
+    const HaarCascadeTree *trees;
+    const HaarCascadeNode *nodes;
+    const float *leaves;
+    const HaarCascadeFeature *features;
+    bool stumpBased;
+};
+
+#endif // HAARCASCADE_H
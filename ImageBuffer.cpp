@@ -44,7 +44,7 @@ ImageBuffer::ImageBuffer(int bufferSize) : bufferSize(bufferSize)
     clearBuffer2 = new QSemaphore(1);
 } // ImageBuffer constructor
 
-void ImageBuffer::addFrame(const IplImage* image)
+void ImageBuffer::addFrame(const IplImage* image, qint64 timestamp)
 {
     clearBuffer1->acquire();
     freeSlots->acquire();
@@ -53,26 +53,103 @@ void ImageBuffer::addFrame(const IplImage* image)
     // Add image to queue
     mutex.lock();
     imageQueue.enqueue(temp);
+    timestampQueue.enqueue(timestamp);
     mutex.unlock();
     clearBuffer1->release();
     usedSlots->release();
 } // addFrame()
 
-IplImage* ImageBuffer::getFrame()
+void ImageBuffer::addFrame(IplImage* image, FrameOwner *owner, qint64 timestamp)
+{
+    clearBuffer1->acquire();
+    freeSlots->acquire();
+    // Add image to queue without copying (image is returned to owner when released)
+    mutex.lock();
+    frameOwners.insert(image,owner);
+    imageQueue.enqueue(image);
+    timestampQueue.enqueue(timestamp);
+    mutex.unlock();
+    clearBuffer1->release();
+    usedSlots->release();
+} // addFrame()
+
+bool ImageBuffer::replaceOldestFrame(const IplImage* image, qint64 timestamp)
+{
+    // Copy the input IplImage
+    return replaceOldestFrame(cvCloneImage(image),NULL,timestamp);
+} // replaceOldestFrame()
+
+bool ImageBuffer::replaceOldestFrame(IplImage* image, FrameOwner *owner, qint64 timestamp)
+{
+    // Adds image without blocking: if buffer is full, oldest image is dropped instead (returns true)
+    IplImage* oldest=NULL;
+    clearBuffer1->acquire();
+    bool full=!freeSlots->tryAcquire();
+    mutex.lock();
+    if(owner!=NULL)
+        frameOwners.insert(image,owner);
+    if(full&&(imageQueue.size()!=0))
+    {
+        // Replace oldest image (number of images in queue is unchanged)
+        oldest=imageQueue.dequeue();
+        timestampQueue.dequeue();
+        imageQueue.enqueue(image);
+        timestampQueue.enqueue(timestamp);
+        mutex.unlock();
+    }
+    else
+    {
+        mutex.unlock();
+        // Queue is empty although buffer is full: consumer has taken the last image and is about to free its slot
+        if(full)
+            freeSlots->acquire();
+        // Add image to queue
+        mutex.lock();
+        imageQueue.enqueue(image);
+        timestampQueue.enqueue(timestamp);
+        mutex.unlock();
+        usedSlots->release();
+    }
+    clearBuffer1->release();
+    // Release dropped image (or return it to its owner)
+    if(oldest==NULL)
+        return false;
+    releaseFrame(oldest);
+    return true;
+} // replaceOldestFrame()
+
+IplImage* ImageBuffer::getFrame(qint64 *timestamp)
 {
     clearBuffer2->acquire();
     usedSlots->acquire();
     IplImage* temp=0;
-    // Take image from queue
+    // Take image (and its capture time) from queue
     mutex.lock();
     temp=imageQueue.dequeue();
+    qint64 captureTime=timestampQueue.dequeue();
     mutex.unlock();
+    if(timestamp!=0)
+        *timestamp=captureTime;
     freeSlots->release();
     clearBuffer2->release();
     // Return image to caller
     return temp;
 } // getFrame()
 
+void ImageBuffer::releaseFrame(IplImage* image)
+{
+    if(image==NULL)
+        return;
+    // Return image to owner (if image was added without copying) or release copy
+    mutex.lock();
+    FrameOwner *owner=frameOwners.take(image);
+    mutex.unlock();
+    if(owner!=NULL)
+        owner->releaseFrame(image);
+    else
+        cvReleaseImage(&image);
+} // releaseFrame()
+
 void ImageBuffer::clearBuffer()
 {
     // Check if buffer is not empty
@@ -95,8 +172,9 @@ void ImageBuffer::clearBuffer()
             IplImage* temp;
             // Dequeue IplImage
             temp=imageQueue.dequeue();
-            // Release IplImage
-            cvReleaseImage(&temp);
+            timestampQueue.dequeue();
+            // Release IplImage (or return it to its owner)
+            releaseFrame(temp);
         }
         // Release all slots
         freeSlots->release(bufferSize);
@@ -37,22 +37,38 @@
 #include <QWaitCondition>
 #include <QMutex>
 #include <QQueue>
+#include <QHash>
 #include <QSemaphore>
 // OpenCV header files
 #include <opencv/highgui.h>
 
+// Owner of frames which are added to the image buffer without copying (e.g. mapped driver buffers)
+class FrameOwner
+{
+
+public:
+    virtual ~FrameOwner() {}
+    virtual void releaseFrame(IplImage *frame)=0;
+};
+
 class ImageBuffer
 {
 
 public:
     ImageBuffer(int size);
-    void addFrame(const IplImage *image);
-    IplImage* getFrame();
+    void addFrame(const IplImage *image, qint64 timestamp=0);
+    void addFrame(IplImage *image, FrameOwner *owner, qint64 timestamp=0);
+    bool replaceOldestFrame(const IplImage *image, qint64 timestamp=0);
+    bool replaceOldestFrame(IplImage *image, FrameOwner *owner, qint64 timestamp=0);
+    IplImage* getFrame(qint64 *timestamp=0);
+    void releaseFrame(IplImage *image);
     void clearBuffer();
     int getSizeOfImageBuffer();
 private:
     QMutex mutex;
     QQueue<IplImage*> imageQueue;
+    QQueue<qint64> timestampQueue; // Capture time of each image (ms since epoch)
+    QHash<IplImage*,FrameOwner*> frameOwners;
     QSemaphore *freeSlots;
     QSemaphore *usedSlots;
     QSemaphore *clearBuffer1;
@@ -33,6 +33,9 @@
 #include "CameraConnectDialog.h"
 #include "ProcessingSettingsDialog.h"
 #include "Controller.h"
+#include "FaceDetect.h"
+#include "BlobExtractor.h"
+#include "FrameLabel.h"
 #include "MainWindow.h"
 
 // Qt header files
@@ -40,15 +43,10 @@
 // Header file containing default values
 #include "DefaultValues.h"
 
-MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
-{  
-    // Setup user interface
-    setupUi(this);
-    // Initially set controller to NULL
-    controller=NULL;
-    // Create processingSettingsDialog
-    processingSettingsDialog = new ProcessingSettingsDialog(this);
-    // Initialize ProcessingFlags structure
+// Processing flags of a newly connected camera
+static ProcessingFlags getDefaultProcessingFlags()
+{
+    ProcessingFlags processingFlags;
     processingFlags.grayscaleOn=false;
     processingFlags.smoothOn=false;
     processingFlags.dilateOn=false;
@@ -56,6 +54,30 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     processingFlags.flipOn=false;
     processingFlags.cannyOn=false;
     processingFlags.facedetectOn=false;
+    processingFlags.motionGatingOn=DEFAULT_MOTION_GATING_ON;
+    processingFlags.backgroundOn=false;
+    processingFlags.blobsOn=false;
+    return processingFlags;
+} // getDefaultProcessingFlags()
+
+MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
+{  
+    // Setup user interface
+    setupUi(this);
+    // Create controller (one pipeline per connected camera)
+    controller=new Controller();
+    // Initially no camera is selected
+    selectedDevice=-1;
+    // Create processingSettingsDialog
+    processingSettingsDialog = new ProcessingSettingsDialog(this);
+    // Create frameTimer (GUI thread takes latest processed frame at display refresh rate)
+    frameTimer = new QTimer(this);
+    frameTimer->setInterval(DEFAULT_DISPLAY_REFRESH_INTERVAL);
+    // Create statisticsTimer (statistics are displayed at a lower rate than frames)
+    statisticsTimer = new QTimer(this);
+    statisticsTimer->setInterval(DEFAULT_STATISTICS_REFRESH_INTERVAL);
+    // Initialize ProcessingFlags structure
+    processingFlags=getDefaultProcessingFlags();
     // Save application version in QString variable
     appVersion=QUOTE(APP_VERSION);
     // Connect signals to slots
@@ -69,68 +91,33 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     connect(flipAction, SIGNAL(toggled(bool)), this, SLOT(setFlip(bool)));
     connect(cannyAction, SIGNAL(toggled(bool)), this, SLOT(setCanny(bool)));
     connect(facedetectAction, SIGNAL(toggled(bool)), this, SLOT(setFacedetect(bool)));
+    connect(backgroundAction, SIGNAL(toggled(bool)), this, SLOT(setBackground(bool)));
+    connect(blobsAction, SIGNAL(toggled(bool)), this, SLOT(setBlobs(bool)));
+    connect(motionGatingAction, SIGNAL(toggled(bool)), this, SLOT(setMotionGating(bool)));
+    connect(overlayAction, SIGNAL(toggled(bool)), this, SLOT(setOverlay(bool)));
     connect(settingsAction, SIGNAL(triggered()), this, SLOT(setProcessingSettings()));
     connect(aboutAction, SIGNAL(triggered()), this, SLOT(about()));
+    connect(frameTimer, SIGNAL(timeout()), this, SLOT(updateFrame()));
+    connect(statisticsTimer, SIGNAL(timeout()), this, SLOT(updateStatistics()));
     connect(clearImageBufferButton, SIGNAL(released()), this, SLOT(clearImageBuffer()));
-    connect(frameLabel, SIGNAL(onMouseMoveEvent()), this, SLOT(updateMouseCursorPosLabel()));
+    connect(processingSettingsDialog, SIGNAL(newProcessingSettings(struct ProcessingSettings)), this, SLOT(updateProcessingSettings(struct ProcessingSettings)));
     qRegisterMetaType<struct MouseData>("MouseData");
-    connect(this->frameLabel,SIGNAL(newMouseData(struct MouseData)),this,SLOT(newMouseData(struct MouseData)));
-    // Enable/disable appropriate menu items
-    connectToCameraAction->setDisabled(false);
-    disconnectCameraAction->setDisabled(true);
-    processingMenu->setDisabled(true);
-    // Set GUI in main window
-    grayscaleAction->setChecked(false);
-    smoothAction->setChecked(false);
-    dilateAction->setChecked(false);
-    erodeAction->setChecked(false);
-    flipAction->setChecked(false);
-    cannyAction->setChecked(false);
-    facedetectAction->setChecked(false);
-    frameLabel->setText("No camera connected.");
-    imageBufferBar->setValue(0);
-    imageBufferLabel->setText("[000/000]");
-    captureRateLabel->setText("");
-    processingRateLabel->setText("");
-    deviceNumberLabel->setText("");
-    cameraResolutionLabel->setText("");
-    roiLabel->setText("");
-    mouseCursorPosLabel->setText("");
-    clearImageBufferButton->setDisabled(true);
+    // Detections are overlaid at display time by default
+    overlayOn=true;
+    overlayAction->setChecked(true);
+    // Set GUI in main window (no camera connected)
+    resetMainWindow();
+    layoutFrameGrid();
 } // MainWindow constructor
 
 MainWindow::~MainWindow()
 {
-    // Check if controller exists
-    if(controller!=NULL)
-    {
-        // Disconnect queued connections
-        disconnect(controller->processingThread,SIGNAL(newFrame(QImage)),this,SLOT(updateFrame(QImage)));
-        disconnect(this,SIGNAL(newProcessingFlags(struct ProcessingFlags)),controller->processingThread,SLOT(updateProcessingFlags(struct ProcessingFlags)));
-        disconnect(this->processingSettingsDialog,SIGNAL(newProcessingSettings(struct ProcessingSettings)),controller->processingThread,SLOT(updateProcessingSettings(struct ProcessingSettings)));
-        disconnect(this,SIGNAL(newTaskData(struct TaskData)),controller->processingThread,SLOT(updateTaskData(struct TaskData)));
-        // Stop processing thread
-        if(controller->processingThread->isRunning())
-            controller->stopProcessingThread();
-        // Stop capture thread
-        if(controller->captureThread->isRunning())
-            controller->stopCaptureThread();
-        // Clear image buffer
-        controller->clearImageBuffer();
-        // Check if threads have stopped
-        if((controller->captureThread->isFinished())&&(controller->processingThread->isFinished()))
-        {
-            // Disconnect camera if connected
-            if(controller->captureThread->isCameraConnected())
-                controller->disconnectCamera();
-            // Delete processing and capture threads
-            controller->deleteProcessingThread();
-            controller->deleteCaptureThread();
-        }
-        // Delete controller
-        delete controller;
-        controller=NULL;
-    }
+    // Stop taking frames and statistics from processing threads
+    frameTimer->stop();
+    statisticsTimer->stop();
+    // Stop all pipelines and disconnect cameras
+    delete controller;
+    controller=NULL;
 } // MainWindow destructor
 
 void MainWindow::connectToCamera()
@@ -144,53 +131,61 @@ void MainWindow::connectToCamera()
         // Set private member variables in cameraConnectDialog to values in dialog
         cameraConnectDialog->setDeviceNumber();
         cameraConnectDialog->setImageBufferSize();
-        // Store image buffer size in local variable
-        imageBufferSize=cameraConnectDialog->getImageBufferSize();
-        // Store device number in local variable
-        deviceNumber=cameraConnectDialog->getDeviceNumber();
-        // Create controller
-        controller = new Controller(deviceNumber,imageBufferSize);
-        // If camera was successfully connected
-        if(controller->captureThread->isCameraConnected())
+        cameraConnectDialog->setLumaCapture();
+        cameraConnectDialog->setV4L2Capture();
+        cameraConnectDialog->setCaptureMode();
+        // Store camera settings in local variable
+        CameraSettings settings;
+        settings.deviceNumber=cameraConnectDialog->getDeviceNumber();
+        settings.imageBufferSize=cameraConnectDialog->getImageBufferSize();
+        settings.lumaOn=cameraConnectDialog->getLumaCaptureOn();
+        settings.v4l2On=cameraConnectDialog->getV4L2CaptureOn();
+        settings.mode=cameraConnectDialog->getCaptureMode();
+        // Display error dialog if camera is already connected
+        int deviceNumber;
+        if(controller->isCameraConnected(settings.deviceNumber))
+            QMessageBox::warning(this,"ERROR:","Camera already connected.");
+        // If camera was successfully connected (any available camera: device number of opened device)
+        else if((deviceNumber=controller->connectToCamera(settings))>=0)
         {
-            // Create queued connection between processing thread (emitter) and GUI thread (receiver/listener)
-            connect(controller->processingThread,SIGNAL(newFrame(QImage)),this,SLOT(updateFrame(QImage)),Qt::QueuedConnection);
-            // Create queued connections between GUI thread (emitter) and processing thread (receiver/listener)
-            qRegisterMetaType<struct ProcessingFlags>("ProcessingFlags");
-            connect(this,SIGNAL(newProcessingFlags(struct ProcessingFlags)),controller->processingThread,SLOT(updateProcessingFlags(struct ProcessingFlags)),Qt::QueuedConnection);
-            qRegisterMetaType<struct ProcessingSettings>("ProcessingSettings");
-            connect(this->processingSettingsDialog,SIGNAL(newProcessingSettings(struct ProcessingSettings)),controller->processingThread,SLOT(updateProcessingSettings(struct ProcessingSettings)),Qt::QueuedConnection);
-            qRegisterMetaType<struct TaskData>("TaskData");
-            connect(this,SIGNAL(newTaskData(struct TaskData)),controller->processingThread,SLOT(updateTaskData(struct TaskData)),Qt::QueuedConnection);
-            // Setup imageBufferBar in main window with minimum and maximum values
-            imageBufferBar->setMinimum(0);
-            imageBufferBar->setMaximum(imageBufferSize);
-            // Enable/disable appropriate menu items
-            connectToCameraAction->setDisabled(true);
-            disconnectCameraAction->setDisabled(false);
-            processingMenu->setDisabled(false);
-            // Enable "Clear Image Buffer" push button in main window
-            clearImageBufferButton->setDisabled(false);
+            CameraPipeline *camera=controller->getCamera(deviceNumber);
+            // Create tile in frame grid
+            CameraView view;
+            view.frameLabel=new FrameLabel(frameGrid);
+            view.frameLabel->setSizePolicy(QSizePolicy::Ignored,QSizePolicy::Ignored);
+            view.frameLabel->setMouseTracking(true);
+            view.frameLabel->setAutoFillBackground(true);
+            view.frameLabel->setFrameShape(QFrame::Box);
+            view.frameLabel->setFrameShadow(QFrame::Raised);
+            view.frameLabel->setAlignment(Qt::AlignCenter);
+            connect(view.frameLabel, SIGNAL(onMouseMoveEvent()), this, SLOT(updateMouseCursorPosLabel()));
+            connect(view.frameLabel, SIGNAL(onMousePressEvent()), this, SLOT(selectCamera()));
+            connect(view.frameLabel, SIGNAL(onResizeEvent()), this, SLOT(updateDisplaySize()));
+            connect(view.frameLabel, SIGNAL(newMouseData(struct MouseData)), this, SLOT(newMouseData(struct MouseData)));
             // Get input stream properties
-            sourceWidth=controller->getInputSourceWidth();
-            sourceHeight=controller->getInputSourceHeight();
-            // Set text in labels in main window
-            deviceNumberLabel->setNum(deviceNumber);
-            cameraResolutionLabel->setText(QString::number(sourceWidth)+QString("x")+QString::number(sourceHeight));
-            /*
-            QThread::IdlePriority               0	scheduled only when no other threads are running.
-            QThread::LowestPriority             1	scheduled less often than LowPriority.
-            QThread::LowPriority                2	scheduled less often than NormalPriority.
-            QThread::NormalPriority             3	the default priority of the operating system.
-            QThread::HighPriority               4	scheduled more often than NormalPriority.
-            QThread::HighestPriority            5	scheduled more often than HighPriority.
-            QThread::TimeCriticalPriority	6	scheduled as often as possible.
-            QThread::InheritPriority            7	use the same priority as the creating thread. This is the default.
-            */
-            // Start capturing frames from camera
-            controller->captureThread->start(QThread::IdlePriority);
-            // Start processing captured frames
-            controller->processingThread->start();
+            view.sourceWidth=camera->getInputSourceWidth();
+            view.sourceHeight=camera->getInputSourceHeight();
+            view.imageBufferSize=settings.imageBufferSize;
+            view.lumaOn=settings.lumaOn;
+            // Frames larger than tile are downscaled by processing thread: mouse coordinates are mapped back to source
+            view.frameLabel->setSourceSize(QSize(view.sourceWidth,view.sourceHeight));
+            // New camera starts with default processing flags (frames are always grayscale if luma capture is ON)
+            // and processing settings currently stored in dialog
+            view.processingFlags=getDefaultProcessingFlags();
+            view.processingFlags.grayscaleOn=settings.lumaOn;
+            view.processingSettings=processingSettingsDialog->getProcessingSettings();
+            camera->processingThread->updateProcessingFlags(view.processingFlags);
+            camera->processingThread->updateProcessingSettings(view.processingSettings);
+            cameraViews.insert(deviceNumber,view);
+            layoutFrameGrid();
+            // Select new camera
+            setSelectedCamera(deviceNumber);
+            // Start capturing and processing frames
+            camera->startThreads();
+            // Start taking processed frames at display refresh rate
+            frameTimer->start();
+            // Start displaying statistics
+            statisticsTimer->start();
         }
         // Display error dialog if camera connection is unsuccessful
         else
@@ -200,63 +195,143 @@ void MainWindow::connectToCamera()
 
 void MainWindow::disconnectCamera()
 {
-    // Check if controller exists
-    if(controller!=NULL)
+    // Check if a camera is selected
+    if(selectedDevice>=0)
     {
-        // Disconnect queued connections
-        disconnect(controller->processingThread,SIGNAL(newFrame(QImage)),this,SLOT(updateFrame(QImage)));
-        disconnect(this,SIGNAL(newProcessingFlags(struct ProcessingFlags)),controller->processingThread,SLOT(updateProcessingFlags(struct ProcessingFlags)));
-        disconnect(this->processingSettingsDialog,SIGNAL(newProcessingSettings(struct ProcessingSettings)),controller->processingThread,SLOT(updateProcessingSettings(struct ProcessingSettings)));
-        disconnect(this,SIGNAL(newTaskData(struct TaskData)),controller->processingThread,SLOT(updateTaskData(struct TaskData)));
-        // Stop processing thread
-        if(controller->processingThread->isRunning())
-            controller->stopProcessingThread();
-        // Stop capture thread
-        if(controller->captureThread->isRunning())
-            controller->stopCaptureThread();
-        // Clear image buffer
-        controller->clearImageBuffer();
-        // Check if threads have stopped
-        if((controller->captureThread->isFinished())&&(controller->processingThread->isFinished()))
+        int deviceNumber=selectedDevice;
+        // Stop pipeline of selected camera and disconnect camera
+        controller->disconnectCamera(deviceNumber);
+        // Remove tile from frame grid
+        delete cameraViews.take(deviceNumber).frameLabel;
+        layoutFrameGrid();
+        // Select first remaining camera
+        if(!cameraViews.isEmpty())
+            setSelectedCamera(cameraViews.keys().first());
+        else
         {
-            // Disconnect camera if connected
-            if(controller->captureThread->isCameraConnected())
-                controller->disconnectCamera();
-            // Delete processing and capture threads
-            controller->deleteProcessingThread();
-            controller->deleteCaptureThread();
+            // Stop taking frames and statistics from processing threads
+            frameTimer->stop();
+            statisticsTimer->stop();
+            // Set GUI in main window (no camera connected)
+            resetMainWindow();
         }
-        // Delete controller
-        delete controller;
-        controller=NULL;
-        // Enable/Disable appropriate menu items
-        connectToCameraAction->setDisabled(false);
-        disconnectCameraAction->setDisabled(true);
-        processingMenu->setDisabled(true);
-        // Set GUI in main window
-        grayscaleAction->setChecked(false);
-        smoothAction->setChecked(false);
-        dilateAction->setChecked(false);
-        erodeAction->setChecked(false);
-        flipAction->setChecked(false);
-        cannyAction->setChecked(false);
-        facedetectAction->setChecked(false);
-        frameLabel->setText("No camera connected.");
-        imageBufferBar->setValue(0);
-        imageBufferLabel->setText("[000/000]");
-        captureRateLabel->setText("");
-        processingRateLabel->setText("");
-        deviceNumberLabel->setText("");
-        cameraResolutionLabel->setText("");
-        roiLabel->setText("");
-        mouseCursorPosLabel->setText("");
-        clearImageBufferButton->setDisabled(true);
     }
     // Display error dialog if camera could not be disconnected
     else
         QMessageBox::warning(this,"ERROR:","Could not disconnect camera.");
 } // disconnectCamera()
 
+void MainWindow::selectCamera()
+{
+    // Select camera whose tile was clicked
+    int deviceNumber=getDeviceNumber(sender());
+    if((deviceNumber>=0)&&(deviceNumber!=selectedDevice))
+        setSelectedCamera(deviceNumber);
+} // selectCamera()
+
+void MainWindow::setSelectedCamera(int deviceNumber)
+{
+    const CameraView &view=cameraViews[deviceNumber];
+    selectedDevice=deviceNumber;
+    // Selected tile is highlighted (frame shadow does not change tile contents size)
+    QMap<int,CameraView>::const_iterator i;
+    for(i=cameraViews.constBegin();i!=cameraViews.constEnd();++i)
+        i.value().frameLabel->setFrameShadow((i.key()==selectedDevice) ? QFrame::Sunken : QFrame::Raised);
+    // Processing menu shows flags of selected camera (action signals are blocked: flags are not published again)
+    processingFlags=view.processingFlags;
+    QList<QAction*> actions=processingMenu->actions();
+    for(int a=0;a<actions.size();a++)
+        actions.at(a)->blockSignals(true);
+    grayscaleAction->setChecked(processingFlags.grayscaleOn);
+    grayscaleAction->setDisabled(view.lumaOn);
+    smoothAction->setChecked(processingFlags.smoothOn);
+    dilateAction->setChecked(processingFlags.dilateOn);
+    erodeAction->setChecked(processingFlags.erodeOn);
+    flipAction->setChecked(processingFlags.flipOn);
+    cannyAction->setChecked(processingFlags.cannyOn);
+    facedetectAction->setChecked(processingFlags.facedetectOn);
+    backgroundAction->setChecked(processingFlags.backgroundOn);
+    blobsAction->setChecked(processingFlags.blobsOn);
+    motionGatingAction->setChecked(processingFlags.motionGatingOn);
+    for(int a=0;a<actions.size();a++)
+        actions.at(a)->blockSignals(false);
+    // Enable/disable appropriate menu items
+    disconnectCameraAction->setDisabled(false);
+    processingMenu->setDisabled(false);
+    // Enable "Clear Image Buffer" push button in main window
+    clearImageBufferButton->setDisabled(false);
+    // Setup imageBufferBar in main window with minimum and maximum values
+    imageBufferBar->setMinimum(0);
+    imageBufferBar->setMaximum(view.imageBufferSize);
+    // Set text in labels in main window
+    deviceNumberLabel->setNum(selectedDevice);
+    cameraResolutionLabel->setText(QString::number(view.sourceWidth)+QString("x")+QString::number(view.sourceHeight));
+    mouseCursorPosLabel->setText("");
+    updateStatistics();
+} // setSelectedCamera()
+
+void MainWindow::resetMainWindow()
+{
+    selectedDevice=-1;
+    // Enable/Disable appropriate menu items
+    connectToCameraAction->setDisabled(false);
+    disconnectCameraAction->setDisabled(true);
+    processingMenu->setDisabled(true);
+    // Set GUI in main window
+    processingFlags=getDefaultProcessingFlags();
+    grayscaleAction->setChecked(false);
+    grayscaleAction->setDisabled(false);
+    smoothAction->setChecked(false);
+    dilateAction->setChecked(false);
+    erodeAction->setChecked(false);
+    flipAction->setChecked(false);
+    cannyAction->setChecked(false);
+    facedetectAction->setChecked(false);
+    backgroundAction->setChecked(false);
+    blobsAction->setChecked(false);
+    motionGatingAction->setChecked(DEFAULT_MOTION_GATING_ON);
+    imageBufferBar->setValue(0);
+    imageBufferLabel->setText("[000/000]");
+    captureRateLabel->setText("");
+    processingRateLabel->setText("");
+    latencyLabel->setText("");
+    skippedFramesLabel->setText("");
+    detectionLabel->setText("");
+    motionLabel->setText("");
+    blobsLabel->setText("");
+    deviceNumberLabel->setText("");
+    cameraResolutionLabel->setText("");
+    roiLabel->setText("");
+    mouseCursorPosLabel->setText("");
+    clearImageBufferButton->setDisabled(true);
+} // resetMainWindow()
+
+void MainWindow::layoutFrameGrid()
+{
+    // Tiles are arranged in a square grid (in ascending order of device number)
+    int nColumns=1;
+    while(nColumns*nColumns<cameraViews.size())
+        nColumns++;
+    int n=0;
+    QMap<int,CameraView>::const_iterator i;
+    for(i=cameraViews.constBegin();i!=cameraViews.constEnd();++i,n++)
+    {
+        frameGridLayout->removeWidget(i.value().frameLabel);
+        frameGridLayout->addWidget(i.value().frameLabel,n/nColumns,n%nColumns);
+    }
+    noCameraLabel->setVisible(cameraViews.isEmpty());
+} // layoutFrameGrid()
+
+int MainWindow::getDeviceNumber(QObject *frameLabel)
+{
+    // Returns -1 if frame label is not a tile in frame grid
+    QMap<int,CameraView>::const_iterator i;
+    for(i=cameraViews.constBegin();i!=cameraViews.constEnd();++i)
+        if(i.value().frameLabel==frameLabel)
+            return i.key();
+    return -1;
+} // getDeviceNumber()
+
 void MainWindow::about()
 {
     QMessageBox::information(this,"About",QString("Written by Nick D'Ademo\n\nContact: nickdademo@gmail.com\nWebsite: www.nickdademo.com\n\nVersion: ")+appVersion);
@@ -264,7 +339,7 @@ void MainWindow::about()
 
 void MainWindow::clearImageBuffer()
 {
-    controller->clearImageBuffer();
+    controller->getCamera(selectedDevice)->clearImageBuffer();
 } // clearImageBuffer()
 
 void MainWindow::setGrayscale(bool input)
@@ -275,8 +350,8 @@ void MainWindow::setGrayscale(bool input)
     // Checked
     else if(input)
         processingFlags.grayscaleOn=true;
-    // Update processing flags in processingThread
-    emit newProcessingFlags(processingFlags);
+    // Update processing flags of selected camera
+    updateProcessingFlags();
 } // setGrayscale()
 
 void MainWindow::setSmooth(bool input)
@@ -287,8 +362,8 @@ void MainWindow::setSmooth(bool input)
     // Checked
     else if(input)
         processingFlags.smoothOn=true;
-    // Update processing flags in processingThread
-    emit newProcessingFlags(processingFlags);
+    // Update processing flags of selected camera
+    updateProcessingFlags();
 } // setSmooth()
 
 void MainWindow::setDilate(bool input)
@@ -299,8 +374,8 @@ void MainWindow::setDilate(bool input)
     // Checked
     else if(input)
         processingFlags.dilateOn=true;
-    // Update processing flags in processingThread
-    emit newProcessingFlags(processingFlags);
+    // Update processing flags of selected camera
+    updateProcessingFlags();
 } // setDilate()
 
 void MainWindow::setErode(bool input)
@@ -311,8 +386,8 @@ void MainWindow::setErode(bool input)
     // Checked
     else if(input)
         processingFlags.erodeOn=true;
-    // Update processing flags in processingThread
-    emit newProcessingFlags(processingFlags);
+    // Update processing flags of selected camera
+    updateProcessingFlags();
 } // setErode()
 
 void MainWindow::setFlip(bool input)
@@ -323,8 +398,8 @@ void MainWindow::setFlip(bool input)
     // Checked
     else if(input)
         processingFlags.flipOn=true;
-    // Update processing flags in processingThread
-    emit newProcessingFlags(processingFlags);
+    // Update processing flags of selected camera
+    updateProcessingFlags();
 } // setFlip()
 
 void MainWindow::setCanny(bool input)
@@ -335,8 +410,8 @@ void MainWindow::setCanny(bool input)
     // Checked
     else if(input)
         processingFlags.cannyOn=true;
-    // Update processing flags in processingThread
-    emit newProcessingFlags(processingFlags);
+    // Update processing flags of selected camera
+    updateProcessingFlags();
 } // setCanny()
 
 void MainWindow::setFacedetect(bool input)
@@ -347,34 +422,161 @@ void MainWindow::setFacedetect(bool input)
     // Checked
     else if(input)
         processingFlags.facedetectOn=true;
-    // Update processing flags in processingThread
-    emit newProcessingFlags(processingFlags);
+    // Update processing flags of selected camera
+    updateProcessingFlags();
 } // setFacedetect()
 
-void MainWindow::updateFrame(const QImage &frame)
+void MainWindow::setBackground(bool input)
 {
+    // Not checked
+    if(!input)
+        processingFlags.backgroundOn=false;
+    // Checked
+    else if(input)
+        processingFlags.backgroundOn=true;
+    // Update processing flags of selected camera
+    updateProcessingFlags();
+} // setBackground()
+
+void MainWindow::setBlobs(bool input)
+{
+    // Not checked
+    if(!input)
+        processingFlags.blobsOn=false;
+    // Checked
+    else if(input)
+        processingFlags.blobsOn=true;
+    // Update processing flags of selected camera
+    updateProcessingFlags();
+} // setBlobs()
+
+void MainWindow::setMotionGating(bool input)
+{
+    // Not checked
+    if(!input)
+        processingFlags.motionGatingOn=false;
+    // Checked
+    else if(input)
+        processingFlags.motionGatingOn=true;
+    // Update processing flags of selected camera
+    updateProcessingFlags();
+} // setMotionGating()
+
+void MainWindow::setOverlay(bool input)
+{
+    // Overlay is drawn in GUI thread: processing thread is not affected
+    overlayOn=input;
+} // setOverlay()
+
+void MainWindow::updateProcessingFlags()
+{
+    // Menu items are also set while no camera is selected
+    if(selectedDevice<0)
+        return;
+    cameraViews[selectedDevice].processingFlags=processingFlags;
+    controller->getCamera(selectedDevice)->processingThread->updateProcessingFlags(processingFlags);
+} // updateProcessingFlags()
+
+void MainWindow::updateProcessingSettings(struct ProcessingSettings processingSettings)
+{
+    // Settings in dialog apply to selected camera only
+    if(selectedDevice<0)
+        return;
+    cameraViews[selectedDevice].processingSettings=processingSettings;
+    controller->getCamera(selectedDevice)->processingThread->updateProcessingSettings(processingSettings);
+} // updateProcessingSettings()
+
+void MainWindow::updateFrame()
+{
+    QMap<int,CameraView>::const_iterator i;
+    for(i=cameraViews.constBegin();i!=cameraViews.constEnd();++i)
+    {
+        FrameLabel *frameLabel=i.value().frameLabel;
+        // Take latest frame from processing thread (NULL if no new frame since last refresh)
+        ProcessedFrame *frame=controller->getCamera(i.key())->processingThread->takeFrame();
+        if(frame==NULL)
+            continue;
+        // Mouse coordinates are mapped to frame coordinates as the frame is displayed (flipped or not)
+        frameLabel->setSourceFlip(frame->flipOn,frame->flipMode,frame->flipRect);
+        // Overlay most recent detections and blobs (frame itself is never drawn into)
+        if(overlayOn&&(!frame->faceDetectResults.detections.empty()||!frame->blobResults.blobs.empty()))
+        {
+            QImage image=frame->image.convertToFormat(QImage::Format_RGB32);
+            QPainter painter(&image);
+            // Detections and blobs are in (unflipped) frame coordinates: flip them as the image (around ROI)
+            if(frame->flipOn)
+            {
+                bool horizontal=(frame->flipMode!=0);
+                bool vertical=(frame->flipMode<=0);
+                const QRect &r=frame->flipRect;
+                painter.translate(horizontal ? (2*r.x()+r.width())*frame->displayScale : 0,
+                                  vertical ? (2*r.y()+r.height())*frame->displayScale : 0);
+                painter.scale(horizontal ? -1 : 1,vertical ? -1 : 1);
+            }
+            drawBlobs(painter,frame->blobResults.blobs,frame->displayScale);
+            drawFaceDetections(painter,frame->faceDetectResults.detections,frame->displayScale);
+            painter.end();
+            // Display frame in tile of camera
+            frameLabel->setPixmap(QPixmap::fromImage(image));
+        }
+        // Display frame in tile of camera
+        else
+            frameLabel->setPixmap(QPixmap::fromImage(frame->image));
+        delete frame;
+    }
+} // updateFrame()
+
+void MainWindow::updateStatistics()
+{
+    // Statistics are shown for selected camera
+    if(selectedDevice<0)
+        return;
+    // Take consistent snapshot of statistics
+    ThreadStatistics statistics=controller->getStatistics(selectedDevice);
     // Show [number of images in buffer / image buffer size] in imageBufferLabel in main window
-    imageBufferLabel->setText(QString("[")+QString::number(controller->processingThread->getCurrentSizeOfBuffer())+
-                              QString("/")+QString::number(imageBufferSize)+QString("]"));
+    imageBufferLabel->setText(QString("[")+QString::number(statistics.currentSizeOfBuffer)+
+                              QString("/")+QString::number(cameraViews[selectedDevice].imageBufferSize)+QString("]"));
     // Show percentage of image bufffer full in imageBufferBar in main window
-    imageBufferBar->setValue(controller->processingThread->getCurrentSizeOfBuffer());
-    // Show processing rate in captureRateLabel in main window
-    captureRateLabel->setNum(controller->captureThread->getAvgFPS());
-    captureRateLabel->setText(captureRateLabel->text()+" fps");
+    imageBufferBar->setValue(statistics.currentSizeOfBuffer);
+    // Show capture rate in captureRateLabel in main window
+    captureRateLabel->setText(QString::number(statistics.captureRate)+" fps ("+
+                              QString::number(statistics.nDroppedFrames)+" dropped)");
     // Show processing rate in processingRateLabel in main window
-    processingRateLabel->setNum(controller->processingThread->getAvgFPS());
-    processingRateLabel->setText(processingRateLabel->text()+" fps");
+    processingRateLabel->setText(QString::number(statistics.processingRate)+" fps");
+    // Show capture-to-processed latency in latencyLabel in main window
+    latencyLabel->setText(QString::number(statistics.latency)+" ms");
+    // Show number of frames not displayed (replaced by a newer frame before display refresh)
+    skippedFramesLabel->setNum(statistics.nSkippedFrames);
+    // Show detection rate and detector parameters currently in use (adjusted by adaptive detection budget)
+    if(statistics.detectionOn)
+        detectionLabel->setText(QString::number(statistics.detectionRate)+" fps (scale "+
+                                QString::number(statistics.detectionParameters.scale,'f',2)+", step "+
+                                QString::number(statistics.detectionParameters.scaleFactor,'f',2)+", min "+
+                                QString::number(statistics.detectionParameters.minSize)+", interval "+
+                                QString::number(statistics.detectionParameters.detectionInterval)+")");
+    else
+        detectionLabel->setText("");
+    // Show fraction of tiles changed since they were last processed (motion gating)
+    if(statistics.motionFraction>=0)
+        motionLabel->setText(QString::number(cvRound(100*statistics.motionFraction))+"% changed");
+    else
+        motionLabel->setText("");
+    // Show number of blobs in current frame
+    if(statistics.nBlobs>=0)
+        blobsLabel->setNum(statistics.nBlobs);
+    else
+        blobsLabel->setText("");
     // Show ROI information in roiLabel in main window
-    roiLabel->setText(QString("(")+QString::number(controller->processingThread->getCurrentROI().x)+QString(",")+
-                      QString::number(controller->processingThread->getCurrentROI().y)+QString(") ")+
-                      QString::number(controller->processingThread->getCurrentROI().width)+
-                      QString("x")+QString::number(controller->processingThread->getCurrentROI().height));
-    // Display frame in main window
-    frameLabel->setPixmap(QPixmap::fromImage(frame));
-} // updateFrame()
+    roiLabel->setText(QString("(")+QString::number(statistics.currentROI.x())+QString(",")+
+                      QString::number(statistics.currentROI.y())+QString(") ")+
+                      QString::number(statistics.currentROI.width())+
+                      QString("x")+QString::number(statistics.currentROI.height()));
+} // updateStatistics()
 
 void MainWindow::setProcessingSettings()
 {
+    // Dialog shows settings of selected camera
+    processingSettingsDialog->setProcessingSettings(cameraViews[selectedDevice].processingSettings);
     // Prompt user:
     // If user presses OK button on dialog, update processing settings
     if(processingSettingsDialog->exec()==1)
@@ -386,7 +588,10 @@ void MainWindow::setProcessingSettings()
 
 void MainWindow::updateMouseCursorPosLabel()
 {
-    // Update mouse cursor position in mouseCursorPosLabel in main window
+    // Update mouse cursor position (in tile under cursor) in mouseCursorPosLabel in main window
+    FrameLabel *frameLabel=qobject_cast<FrameLabel*>(sender());
+    if(frameLabel==NULL)
+        return;
     mouseCursorPosLabel->setText(QString("(")+QString::number(frameLabel->getMouseCursorPos().x())+
                                  QString(",")+QString::number(frameLabel->getMouseCursorPos().y())+
                                  QString(")"));
@@ -396,6 +601,12 @@ void MainWindow::newMouseData(struct MouseData mouseData)
 {
     // Local variables
     int x_temp, y_temp, width_temp, height_temp;
+    // Mouse data is sent to camera whose tile was used
+    int deviceNumber=getDeviceNumber(sender());
+    if(deviceNumber<0)
+        return;
+    const CameraView &view=cameraViews[deviceNumber];
+    ProcessingThread *processingThread=controller->getCamera(deviceNumber)->processingThread;
     // Set ROI
     if(mouseData.leftButtonRelease)
     {
@@ -424,8 +635,8 @@ void MainWindow::newMouseData(struct MouseData mouseData)
             }
             // Check if selection box is not outside window
             if((taskData.selectionBox.x()<0)||(taskData.selectionBox.y()<0)||
-               ((taskData.selectionBox.x()+taskData.selectionBox.width())>sourceWidth)||
-               ((taskData.selectionBox.y()+taskData.selectionBox.height())>sourceHeight))
+               ((taskData.selectionBox.x()+taskData.selectionBox.width())>view.sourceWidth)||
+               ((taskData.selectionBox.y()+taskData.selectionBox.height())>view.sourceHeight))
             {
                 // Display error message
                 QMessageBox::warning(this,"ERROR:","Selection box outside range. Please try again.");
@@ -435,7 +646,7 @@ void MainWindow::newMouseData(struct MouseData mouseData)
                 // Set setROIFlag to TRUE
                 taskData.setROIFlag=true;
                 // Update task data in processingThread
-                emit newTaskData(taskData);
+                processingThread->updateTaskData(taskData);
                 // Set setROIFlag to FALSE
                 taskData.setROIFlag=false;
             }
@@ -447,8 +658,17 @@ void MainWindow::newMouseData(struct MouseData mouseData)
         // Set resetROIFlag to TRUE
         taskData.resetROIFlag=true;
         // Update task data in processingThread
-        emit newTaskData(taskData);
+        processingThread->updateTaskData(taskData);
         // Set resetROIFlag to FALSE
         taskData.resetROIFlag=false;
     }
 } // newMouseData()
+
+void MainWindow::updateDisplaySize()
+{
+    // Update display size in processingThread of resized tile (frames are downscaled to fit inside tile)
+    int deviceNumber=getDeviceNumber(sender());
+    if(deviceNumber<0)
+        return;
+    controller->getCamera(deviceNumber)->processingThread->updateDisplaySize(cameraViews[deviceNumber].frameLabel->contentsRect().size());
+} // updateDisplaySize()
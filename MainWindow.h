@@ -42,6 +42,18 @@
 class CameraConnectDialog;
 class ProcessingSettingsDialog;
 class Controller;
+class FrameLabel;
+
+// CameraView structure definition (display state of one connected camera: one tile in frame grid)
+struct CameraView{
+    FrameLabel *frameLabel;
+    ProcessingFlags processingFlags;
+    ProcessingSettings processingSettings;
+    int sourceWidth;
+    int sourceHeight;
+    int imageBufferSize;
+    bool lumaOn;
+};
 
 class MainWindow : public QMainWindow, private Ui::MainWindow
 {
@@ -51,16 +63,22 @@ public:
     MainWindow(QWidget *parent = 0);
     ~MainWindow();
 private:
+    void setSelectedCamera(int deviceNumber);
+    void updateProcessingFlags();
+    void layoutFrameGrid();
+    void resetMainWindow();
+    int getDeviceNumber(QObject *frameLabel);
     CameraConnectDialog *cameraConnectDialog;
     ProcessingSettingsDialog *processingSettingsDialog;
     Controller *controller;
-    ProcessingFlags processingFlags;
+    QTimer *frameTimer;
+    QTimer *statisticsTimer;
+    QMap<int,CameraView> cameraViews;
+    int selectedDevice; // -1 if no camera is connected
+    ProcessingFlags processingFlags; // Flags of selected camera (shown in processing menu)
+    bool overlayOn;
     TaskData taskData;
     QString appVersion;
-    int sourceWidth;
-    int sourceHeight;
-    int deviceNumber;
-    int imageBufferSize;
 public slots:
     void connectToCamera();
     void disconnectCamera();
@@ -73,14 +91,19 @@ public slots:
     void setFlip(bool);
     void setCanny(bool);
     void setFacedetect(bool);
+    void setBackground(bool);
+    void setBlobs(bool);
+    void setMotionGating(bool);
+    void setOverlay(bool);
     void setProcessingSettings();
     void updateMouseCursorPosLabel();
     void newMouseData(struct MouseData);
+    void updateDisplaySize();
+    void selectCamera();
 private slots:
-    void updateFrame(const QImage &frame);
-signals:
-    void newProcessingFlags(struct ProcessingFlags p_flags);
-    void newTaskData(struct TaskData taskData);
+    void updateFrame();
+    void updateStatistics();
+    void updateProcessingSettings(struct ProcessingSettings p_settings);
 };
 
 #endif // MAINWINDOW_H
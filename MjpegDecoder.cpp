@@ -0,0 +1,379 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* MjpegDecoder.cpp                                                     */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "MjpegDecoder.h"
+#include "V4L2Capture.h"
+
+// Qt header files
+#include <QDebug>
+#include <QRunnable>
+// Header file containing default values
+#include "DefaultValues.h"
+
+#include <csetjmp>
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <jpeglib.h>
+#include <jerror.h>
+}
+
+// Standard Huffman tables (JPEG specification K.3): MJPEG frames of most cameras do not contain Huffman tables
+static const UINT8 dcLuminanceBits[17]={0,0,1,5,1,1,1,1,1,1,0,0,0,0,0,0,0};
+static const UINT8 dcChrominanceBits[17]={0,0,3,1,1,1,1,1,1,1,1,1,0,0,0,0,0};
+static const UINT8 dcValues[12]={0,1,2,3,4,5,6,7,8,9,10,11};
+static const UINT8 acLuminanceBits[17]={0,0,2,1,3,3,2,4,3,5,5,4,4,0,0,1,0x7d};
+static const UINT8 acLuminanceValues[162]={
+    0x01,0x02,0x03,0x00,0x04,0x11,0x05,0x12,0x21,0x31,0x41,0x06,0x13,0x51,0x61,0x07,
+    0x22,0x71,0x14,0x32,0x81,0x91,0xa1,0x08,0x23,0x42,0xb1,0xc1,0x15,0x52,0xd1,0xf0,
+    0x24,0x33,0x62,0x72,0x82,0x09,0x0a,0x16,0x17,0x18,0x19,0x1a,0x25,0x26,0x27,0x28,
+    0x29,0x2a,0x34,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,0x49,
+    0x4a,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5a,0x63,0x64,0x65,0x66,0x67,0x68,0x69,
+    0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x83,0x84,0x85,0x86,0x87,0x88,0x89,
+    0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,0xa6,0xa7,
+    0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,0xb5,0xb6,0xb7,0xb8,0xb9,0xba,0xc2,0xc3,0xc4,0xc5,
+    0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,0xe1,0xe2,
+    0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf1,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,
+    0xf9,0xfa};
+static const UINT8 acChrominanceBits[17]={0,0,2,1,2,4,4,3,4,7,5,4,4,0,1,2,0x77};
+static const UINT8 acChrominanceValues[162]={
+    0x00,0x01,0x02,0x03,0x11,0x04,0x05,0x21,0x31,0x06,0x12,0x41,0x51,0x07,0x61,0x71,
+    0x13,0x22,0x32,0x81,0x08,0x14,0x42,0x91,0xa1,0xb1,0xc1,0x09,0x23,0x33,0x52,0xf0,
+    0x15,0x62,0x72,0xd1,0x0a,0x16,0x24,0x34,0xe1,0x25,0xf1,0x17,0x18,0x19,0x1a,0x26,
+    0x27,0x28,0x29,0x2a,0x35,0x36,0x37,0x38,0x39,0x3a,0x43,0x44,0x45,0x46,0x47,0x48,
+    0x49,0x4a,0x53,0x54,0x55,0x56,0x57,0x58,0x59,0x5a,0x63,0x64,0x65,0x66,0x67,0x68,
+    0x69,0x6a,0x73,0x74,0x75,0x76,0x77,0x78,0x79,0x7a,0x82,0x83,0x84,0x85,0x86,0x87,
+    0x88,0x89,0x8a,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0xa2,0xa3,0xa4,0xa5,
+    0xa6,0xa7,0xa8,0xa9,0xaa,0xb2,0xb3,0xb4,0xb5,0xb6,0xb7,0xb8,0xb9,0xba,0xc2,0xc3,
+    0xc4,0xc5,0xc6,0xc7,0xc8,0xc9,0xca,0xd2,0xd3,0xd4,0xd5,0xd6,0xd7,0xd8,0xd9,0xda,
+    0xe2,0xe3,0xe4,0xe5,0xe6,0xe7,0xe8,0xe9,0xea,0xf2,0xf3,0xf4,0xf5,0xf6,0xf7,0xf8,
+    0xf9,0xfa};
+
+// Error handling: decoding of frame is abandoned (libjpeg would exit)
+struct JpegErrorManager{
+    struct jpeg_error_mgr manager;
+    jmp_buf setjmpBuffer;
+    bool truncated;
+};
+
+static void jpegErrorExit(j_common_ptr cinfo)
+{
+    longjmp(((JpegErrorManager*)cinfo->err)->setjmpBuffer,1);
+} // jpegErrorExit()
+
+static void jpegOutputMessage(j_common_ptr)
+{
+    // Warnings (e.g. corrupt data) are not printed for every frame
+} // jpegOutputMessage()
+
+static void jpegEmitMessage(j_common_ptr cinfo, int msgLevel)
+{
+    // Truncated frame (end of data or marker hit inside entropy-coded data) is recorded: other warnings
+    // (e.g. extraneous bytes before marker, raised by many cameras for every frame) are harmless
+    JpegErrorManager *error=(JpegErrorManager*)cinfo->err;
+    if((msgLevel<0)&&((error->manager.msg_code==JWRN_JPEG_EOF)||(error->manager.msg_code==JWRN_HIT_MARKER)))
+        error->truncated=true;
+} // jpegEmitMessage()
+
+// Source manager reading from memory (mapped driver buffer)
+static void initSource(j_decompress_ptr)
+{
+} // initSource()
+
+static boolean fillInputBuffer(j_decompress_ptr cinfo)
+{
+    // Truncated frame: end of image marker is inserted so that decoding ends, with a warning (frame is dropped)
+    static const JOCTET endOfImage[2]={0xFF,JPEG_EOI};
+    WARNMS(cinfo,JWRN_JPEG_EOF);
+    cinfo->src->next_input_byte=endOfImage;
+    cinfo->src->bytes_in_buffer=2;
+    return TRUE;
+} // fillInputBuffer()
+
+static void skipInputData(j_decompress_ptr cinfo, long nBytes)
+{
+    if(nBytes<=0)
+        return;
+    if((size_t)nBytes>cinfo->src->bytes_in_buffer)
+        fillInputBuffer(cinfo);
+    else
+    {
+        cinfo->src->next_input_byte+=nBytes;
+        cinfo->src->bytes_in_buffer-=nBytes;
+    }
+} // skipInputData()
+
+static void termSource(j_decompress_ptr)
+{
+} // termSource()
+
+static void setHuffmanTable(j_decompress_ptr cinfo, JHUFF_TBL **table, const UINT8 *bits, const UINT8 *values)
+{
+    // Table is only set if frame does not contain it
+    if(*table!=NULL)
+        return;
+    *table=jpeg_alloc_huff_table((j_common_ptr)cinfo);
+    memcpy((*table)->bits,bits,sizeof((*table)->bits));
+    int nValues=0;
+    for(int i=1;i<=16;i++)
+        nValues+=bits[i];
+    memcpy((*table)->huffval,values,nValues);
+    (*table)->sent_table=FALSE;
+} // setHuffmanTable()
+
+// Decodes a buffer in a thread pool thread
+class MjpegDecodeTask : public QRunnable
+{
+
+public:
+    MjpegDecodeTask(MjpegDecoder *decoder, int sequence, int bufferIndex, const uchar *data, int size, qint64 timestamp)
+        : decoder(decoder), sequence(sequence), bufferIndex(bufferIndex), data(data), size(size), timestamp(timestamp) {}
+    void run()
+    {
+        decoder->decodeBuffer(sequence,bufferIndex,data,size,timestamp);
+    }
+private:
+    MjpegDecoder *decoder;
+    int sequence;
+    int bufferIndex;
+    const uchar *data;
+    int size;
+    qint64 timestamp;
+};
+
+MjpegDecoder::MjpegDecoder(ImageBuffer *imageBuffer, V4L2Capture *capture, bool lumaOn, int scale)
+    : imageBuffer(imageBuffer), capture(capture), lumaOn(lumaOn), scale(scale)
+{
+    // libjpeg scales by 1/1, 1/2, 1/4 or 1/8
+    if((scale!=2)&&(scale!=4)&&(scale!=8))
+        this->scale=1;
+    threadPool.setMaxThreadCount(DEFAULT_MJPEG_DECODE_THREADS);
+    nextSequence=0;
+    nextDeliveredSequence=0;
+    delivering=false;
+    stopped=false;
+} // MjpegDecoder constructor
+
+MjpegDecoder::~MjpegDecoder()
+{
+    // Wait for any tasks still running (frames which are not delivered are released)
+    stop();
+    // Release pooled frames (all delivered frames must have been released)
+    for(std::map<int,DecodedFrame>::iterator i=decodedFrames.begin();i!=decodedFrames.end();i++)
+    {
+        if(i->second.frame!=NULL)
+            cvReleaseImage(&i->second.frame);
+    }
+    for(unsigned int i=0;i<freeFrames.size();i++)
+        cvReleaseImage(&freeFrames[i]);
+} // MjpegDecoder destructor
+
+void MjpegDecoder::decode(int bufferIndex, const uchar *data, int size, qint64 timestamp)
+{
+    // Called in capture thread: buffer is decoded in thread pool (frames are numbered in capture order)
+    mutex.lock();
+    int sequence=nextSequence++;
+    mutex.unlock();
+    threadPool.start(new MjpegDecodeTask(this,sequence,bufferIndex,data,size,timestamp));
+} // decode()
+
+void MjpegDecoder::decodeBuffer(int sequence, int bufferIndex, const uchar *data, int size, qint64 timestamp)
+{
+    DecodedFrame decoded;
+    decoded.frame=decodeFrame(data,size);
+    decoded.timestamp=timestamp;
+    // Driver buffer has been read: it is queued again
+    capture->releaseBuffer(bufferIndex);
+    mutex.lock();
+    decodedFrames[sequence]=decoded;
+    mutex.unlock();
+    deliverFrames();
+} // decodeBuffer()
+
+void MjpegDecoder::deliverFrames()
+{
+    // Frames are added to image buffer in capture order by one thread at a time
+    // (a thread which finds another thread delivering leaves its frame to that thread)
+    QMutexLocker locker(&mutex);
+    if(delivering)
+        return;
+    delivering=true;
+    std::map<int,DecodedFrame>::iterator next;
+    while((next=decodedFrames.find(nextDeliveredSequence))!=decodedFrames.end())
+    {
+        DecodedFrame decoded=next->second;
+        decodedFrames.erase(next);
+        nextDeliveredSequence++;
+        // Frame replaces oldest frame in image buffer if it is full (oldest frame is returned to pool)
+        locker.unlock();
+        if(decoded.frame!=NULL)
+        {
+            if(stopped)
+                releaseFrame(decoded.frame);
+            else if(imageBuffer->replaceOldestFrame(decoded.frame,this,decoded.timestamp))
+                droppedFrames.ref();
+        }
+        locker.relock();
+    }
+    delivering=false;
+} // deliverFrames()
+
+void MjpegDecoder::releaseFrame(IplImage *frame)
+{
+    // Frame is returned to pool
+    QMutexLocker locker(&mutex);
+    freeFrames.push_back(frame);
+} // releaseFrame()
+
+void MjpegDecoder::stop()
+{
+    // Frames decoded from now on are released instead of delivered
+    stopped=true;
+    threadPool.waitForDone();
+} // stop()
+
+int MjpegDecoder::getNumberOfPendingFrames()
+{
+    // Frames being decoded or waiting for earlier frames
+    QMutexLocker locker(&mutex);
+    return nextSequence-nextDeliveredSequence;
+} // getNumberOfPendingFrames()
+
+int MjpegDecoder::getNumberOfDroppedFrames()
+{
+    return (int)droppedFrames;
+} // getNumberOfDroppedFrames()
+
+int MjpegDecoder::getScaledSize(int size)
+{
+    // Size of decoded frame (as computed by libjpeg)
+    return (size+scale-1)/scale;
+} // getScaledSize()
+
+IplImage* MjpegDecoder::takeFrame(int width, int height)
+{
+    int nChannels=lumaOn ? 1 : 3;
+    // Take frame of same size from pool (frames of other sizes are not needed any more)
+    mutex.lock();
+    IplImage *frame=NULL;
+    while(!freeFrames.empty()&&(frame==NULL))
+    {
+        IplImage *pooled=freeFrames.back();
+        freeFrames.pop_back();
+        if((pooled->width==width)&&(pooled->height==height)&&(pooled->nChannels==nChannels))
+            frame=pooled;
+        else
+            cvReleaseImage(&pooled);
+    }
+    mutex.unlock();
+    // Pool grows until it holds all frames in use (frames being decoded, in image buffer and being processed)
+    if(frame==NULL)
+        frame=cvCreateImage(cvSize(width,height),IPL_DEPTH_8U,nChannels);
+    // ROI set by previous consumer of frame is removed
+    cvResetImageROI(frame);
+    return frame;
+} // takeFrame()
+
+IplImage* MjpegDecoder::decodeFrame(const uchar *data, int size)
+{
+    // Local variables
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_source_mgr source;
+    JpegErrorManager error;
+    IplImage * volatile frame=NULL;
+    JSAMPROW rows[16];
+
+    cinfo.err=jpeg_std_error(&error.manager);
+    error.manager.error_exit=jpegErrorExit;
+    error.manager.output_message=jpegOutputMessage;
+    error.manager.emit_message=jpegEmitMessage;
+    error.truncated=false;
+    // Corrupt frame: frame is dropped
+    if(setjmp(error.setjmpBuffer))
+    {
+        jpeg_destroy_decompress(&cinfo);
+        if(frame!=NULL)
+            releaseFrame(frame);
+        return NULL;
+    }
+    jpeg_create_decompress(&cinfo);
+    source.init_source=initSource;
+    source.fill_input_buffer=fillInputBuffer;
+    source.skip_input_data=skipInputData;
+    source.resync_to_restart=jpeg_resync_to_restart;
+    source.term_source=termSource;
+    source.next_input_byte=data;
+    source.bytes_in_buffer=size;
+    cinfo.src=&source;
+    jpeg_read_header(&cinfo,TRUE);
+    setHuffmanTable(&cinfo,&cinfo.dc_huff_tbl_ptrs[0],dcLuminanceBits,dcValues);
+    setHuffmanTable(&cinfo,&cinfo.dc_huff_tbl_ptrs[1],dcChrominanceBits,dcValues);
+    setHuffmanTable(&cinfo,&cinfo.ac_huff_tbl_ptrs[0],acLuminanceBits,acLuminanceValues);
+    setHuffmanTable(&cinfo,&cinfo.ac_huff_tbl_ptrs[1],acChrominanceBits,acChrominanceValues);
+    // Scaled decoding: inverse DCTs of reduced size (1/2: 4x4, 1/4: 2x2, 1/8: DC only)
+    cinfo.scale_num=1;
+    cinfo.scale_denom=scale;
+    // Luma only: chroma components are not transformed, upsampled or converted
+    if(lumaOn)
+        cinfo.out_color_space=JCS_GRAYSCALE;
+    else
+#ifdef JCS_EXTENSIONS
+        cinfo.out_color_space=JCS_EXT_BGR;
+#else
+        cinfo.out_color_space=JCS_RGB;
+#endif
+    jpeg_start_decompress(&cinfo);
+    frame=takeFrame(cinfo.output_width,cinfo.output_height);
+    while(cinfo.output_scanline<cinfo.output_height)
+    {
+        int nRows=0;
+        for(unsigned int y=cinfo.output_scanline;(y<cinfo.output_height)&&(nRows<16);y++)
+            rows[nRows++]=(JSAMPROW)(frame->imageData+y*frame->widthStep);
+        jpeg_read_scanlines(&cinfo,rows,nRows);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    // Truncated frame (decoded up to inserted end of image marker): frame is dropped
+    if(error.truncated)
+    {
+        releaseFrame(frame);
+        return NULL;
+    }
+#ifndef JCS_EXTENSIONS
+    if(!lumaOn)
+        cvCvtColor(frame,frame,CV_RGB2BGR);
+#endif
+    return frame;
+} // decodeFrame()
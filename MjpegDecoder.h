@@ -0,0 +1,95 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* MjpegDecoder.h                                                       */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef MJPEGDECODER_H
+#define MJPEGDECODER_H
+
+#include "ImageBuffer.h"
+
+// Qt header files
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThreadPool>
+// OpenCV header files
+#include <opencv/cv.h>
+
+#include <map>
+#include <vector>
+
+class V4L2Capture;
+
+// Decoded frame waiting for earlier frames
+struct DecodedFrame{
+    IplImage *frame; // NULL: frame could not be decoded
+    qint64 timestamp;
+};
+
+// Decodes compressed (MJPEG) driver buffers on a thread pool.
+// Capture thread only dequeues buffers: each buffer is decoded (directly from the mapped driver buffer, which is then
+// released) into a pooled frame, optionally at 1/2, 1/4 or 1/8 scale (DCT-domain scaling: reduced IDCTs, no resize)
+// and as luma only if luma capture is ON (chroma is not transformed). Decoded frames are added to the image buffer
+// in capture order and returned to the pool when released.
+class MjpegDecoder : public FrameOwner
+{
+
+public:
+    MjpegDecoder(ImageBuffer *imageBuffer, V4L2Capture *capture, bool lumaOn, int scale);
+    ~MjpegDecoder();
+    void decode(int bufferIndex, const uchar *data, int size, qint64 timestamp);
+    void decodeBuffer(int sequence, int bufferIndex, const uchar *data, int size, qint64 timestamp);
+    void releaseFrame(IplImage *frame);
+    void stop();
+    int getNumberOfPendingFrames();
+    int getNumberOfDroppedFrames();
+    int getScaledSize(int size);
+private:
+    IplImage* decodeFrame(const uchar *data, int size);
+    IplImage* takeFrame(int width, int height);
+    void deliverFrames();
+    ImageBuffer *imageBuffer;
+    V4L2Capture *capture;
+    bool lumaOn;
+    int scale;
+    QThreadPool threadPool;
+    QMutex mutex;
+    int nextSequence;
+    int nextDeliveredSequence;
+    std::map<int,DecodedFrame> decodedFrames;
+    std::vector<IplImage*> freeFrames;
+    bool delivering;
+    QAtomicInt droppedFrames;
+    volatile bool stopped;
+};
+
+#endif // MJPEGDECODER_H
@@ -0,0 +1,102 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* MotionDetector.cpp                                                   */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+
+
+#include "MotionDetector.h"
+
+// OpenCV header files
+#include <opencv2/imgproc/imgproc.hpp>
+// Header file containing default values
+#include "DefaultValues.h"
+
+#include <algorithm>
+
+MotionDetector::MotionDetector()
+{
+} // MotionDetector constructor
+
+void MotionDetector::reset()
+{
+    // Whole frame is reported as changed at next detection
+    reference.release();
+} // reset()
+
+double MotionDetector::detect(const cv::Mat &frame, std::vector<cv::Rect> &regions)
+{
+    // Local variables
+    std::vector<std::vector<cv::Point> > contours;
+    int tileSize=DEFAULT_MOTION_TILE_SIZE;
+
+    regions.clear();
+    // Downsampled grayscale frame (area interpolation also suppresses sensor noise)
+    cv::resize(frame,smallFrame,cv::Size(std::max(1,frame.cols/DEFAULT_MOTION_DOWNSAMPLE),
+                                         std::max(1,frame.rows/DEFAULT_MOTION_DOWNSAMPLE)),0,0,cv::INTER_AREA);
+    if(smallFrame.channels()==3)
+        cv::cvtColor(smallFrame,grayFrame,CV_BGR2GRAY);
+    else
+        smallFrame.copyTo(grayFrame);
+    // No reference (or frame size has changed): whole frame has changed
+    if(reference.size()!=grayFrame.size())
+    {
+        grayFrame.copyTo(reference);
+        regions.push_back(cv::Rect(0,0,frame.cols,frame.rows));
+        return 1.;
+    }
+    // Changed pixels
+    cv::absdiff(grayFrame,reference,difference);
+    cv::threshold(difference,difference,DEFAULT_MOTION_THRESHOLD,255,cv::THRESH_BINARY);
+    // Fraction of changed pixels per tile (area interpolation averages each tile)
+    cv::resize(difference,tiles,cv::Size((frame.cols+tileSize-1)/tileSize,(frame.rows+tileSize-1)/tileSize),0,0,cv::INTER_AREA);
+    cv::threshold(tiles,tiles,255*DEFAULT_MOTION_TILE_FRACTION,255,cv::THRESH_BINARY);
+    int nChangedTiles=cv::countNonZero(tiles);
+    if(nChangedTiles==0)
+        return 0.;
+    // Reference is updated in changed tiles only
+    cv::resize(tiles,tileMask,grayFrame.size(),0,0,cv::INTER_NEAREST);
+    grayFrame.copyTo(reference,tileMask);
+    double changedFraction=(double)nChangedTiles/(tiles.cols*tiles.rows);
+    // Changed regions: bounding rectangles of groups of neighbouring changed tiles
+    cv::findContours(tiles,contours,CV_RETR_EXTERNAL,CV_CHAIN_APPROX_SIMPLE);
+    double scaleX=(double)frame.cols/tiles.cols;
+    double scaleY=(double)frame.rows/tiles.rows;
+    for(std::vector<std::vector<cv::Point> >::const_iterator contour=contours.begin();contour!=contours.end();contour++)
+    {
+        cv::Rect tileRect=cv::boundingRect(cv::Mat(*contour));
+        regions.push_back(cv::Rect(cvFloor(tileRect.x*scaleX),cvFloor(tileRect.y*scaleY),
+                                   cvCeil(tileRect.width*scaleX),cvCeil(tileRect.height*scaleY))&
+                          cv::Rect(0,0,frame.cols,frame.rows));
+    }
+    return changedFraction;
+} // detect()
@@ -0,0 +1,64 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* MotionDetector.h                                                     */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+
+
+#ifndef MOTIONDETECTOR_H
+#define MOTIONDETECTOR_H
+
+// OpenCV header files
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+// Finds tiles of the frame that changed since they were last reported as changed
+// (evaluated on a downsampled grayscale frame: cheap enough to run on every frame).
+// The reference of unchanged tiles is kept, so slow changes add up until the tile is reported.
+class MotionDetector
+{
+
+public:
+    MotionDetector();
+    void reset();
+    double detect(const cv::Mat &frame, std::vector<cv::Rect> &regions);
+private:
+    cv::Mat smallFrame;
+    cv::Mat grayFrame;
+    cv::Mat reference;
+    cv::Mat difference;
+    cv::Mat tiles;
+    cv::Mat tileMask;
+};
+
+#endif // MOTIONDETECTOR_H
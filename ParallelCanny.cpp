@@ -0,0 +1,263 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* ParallelCanny.cpp                                                    */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+
+
+#include "ParallelCanny.h"
+
+// Qt header files
+#include <QRunnable>
+// OpenCV header files
+#include <opencv2/imgproc/imgproc.hpp>
+// Header file containing default values
+#include "DefaultValues.h"
+
+#include <cstdlib>
+
+// Fixed-point tangent of 22.5 degrees (as in cv::Canny())
+#define CANNY_SHIFT 15
+#define CANNY_TG22 ((int)(0.4142135623730950488016887242097*(1<<CANNY_SHIFT)+0.5))
+
+// Processes a band of rows in a thread pool thread
+class CannyBandTask : public QRunnable
+{
+
+public:
+    CannyBandTask(ParallelCanny *parallelCanny, int bandIndex, bool write)
+        : parallelCanny(parallelCanny), bandIndex(bandIndex), write(write) {}
+    void run()
+    {
+        if(write)
+            parallelCanny->writeBand(bandIndex);
+        else
+            parallelCanny->processBand(bandIndex);
+    }
+private:
+    ParallelCanny *parallelCanny;
+    int bandIndex;
+    bool write;
+};
+
+ParallelCanny::ParallelCanny()
+{
+} // ParallelCanny constructor
+
+ParallelCanny::~ParallelCanny()
+{
+    // Wait for any tasks still running (tasks reference bands)
+    threadPool.waitForDone();
+} // ParallelCanny destructor
+
+void ParallelCanny::apply(const cv::Mat &src, cv::Mat &dst, double threshold1, double threshold2, int apertureSize)
+{
+    // Local variables
+    int nBands=(src.rows+DEFAULT_CANNY_BAND_ROWS-1)/DEFAULT_CANNY_BAND_ROWS;
+
+    CV_Assert(src.type()==CV_8UC1);
+    CV_Assert(((apertureSize&1)==1)&&(apertureSize>=3)&&(apertureSize<=7));
+    // Thresholds as in cv::Canny()
+    if(threshold1>threshold2)
+        std::swap(threshold1,threshold2);
+    low=cvFloor(threshold1);
+    high=cvFloor(threshold2);
+    aperture=apertureSize;
+    // Destination may be the source itself (destination is written once all bands have read the source)
+    if((dst.size()!=src.size())||(dst.type()!=CV_8UC1))
+        dst.create(src.size(),CV_8UC1);
+    if(src.empty())
+        return;
+    // Map has a border of 1 (no edge): edge following never leaves the image
+    if((map.rows!=src.rows+2)||(map.cols!=src.cols+2))
+        map.create(src.rows+2,src.cols+2,CV_8UC1);
+    map.row(0).setTo(cv::Scalar(1));
+    map.row(src.rows+1).setTo(cv::Scalar(1));
+    // First pass: gradients, non-maxima suppression and hysteresis within each band (in parallel)
+    currentSrc=src;
+    currentDst=dst;
+    bands.resize(nBands);
+    for(int b=0;b<nBands;b++)
+    {
+        bands[b].yBegin=b*DEFAULT_CANNY_BAND_ROWS;
+        bands[b].yEnd=qMin(bands[b].yBegin+DEFAULT_CANNY_BAND_ROWS,src.rows);
+        threadPool.start(new CannyBandTask(this,b,false));
+    }
+    threadPool.waitForDone();
+    // Second pass: follow edges crossing band borders (edges reaching the last row of a band continue in candidates
+    // of the first row of the next band and vice versa)
+    stack.clear();
+    for(int b=1;b<nBands;b++)
+    {
+        uchar *upper=map.ptr<uchar>(bands[b].yBegin)+1;
+        uchar *lower=map.ptr<uchar>(bands[b].yBegin+1)+1;
+        for(int j=0;j<src.cols;j++)
+        {
+            for(int k=-1;k<=1;k++)
+            {
+                if((upper[j]==2)&&(lower[j+k]==0))
+                {
+                    lower[j+k]=2;
+                    stack.push_back(lower+j+k);
+                }
+                if((lower[j]==2)&&(upper[j+k]==0))
+                {
+                    upper[j+k]=2;
+                    stack.push_back(upper+j+k);
+                }
+            }
+        }
+    }
+    followEdges(stack,0,src.rows);
+    // Write edges to destination (in parallel)
+    for(int b=0;b<nBands;b++)
+        threadPool.start(new CannyBandTask(this,b,true));
+    threadPool.waitForDone();
+    currentSrc.release();
+    currentDst.release();
+} // apply()
+
+void ParallelCanny::processBand(int bandIndex)
+{
+    // Called concurrently for different bands: band only writes its own rows of map
+    CannyBand &band=bands[bandIndex];
+    int rows=currentSrc.rows;
+    int cols=currentSrc.cols;
+    int r=aperture/2;
+    int magStep=cols+2;
+    // Gradients are needed one row above and below the band (non-maxima suppression)
+    int gradientBegin=qMax(0,band.yBegin-1);
+    int gradientEnd=qMin(rows,band.yEnd+1);
+    int sourceBegin=qMax(0,gradientBegin-r);
+    int sourceEnd=qMin(rows,gradientEnd+r);
+    // Source rows with halo: pixels outside an ROI are read from the parent image and image borders are replicated
+    // (as by the Sobel filters of cvCanny())
+    cv::copyMakeBorder(currentSrc.rowRange(sourceBegin,sourceEnd),band.padded,
+                       r-(gradientBegin-sourceBegin),r-(sourceEnd-gradientEnd),r,r,
+                       cv::BORDER_REPLICATE);
+    cv::Sobel(band.padded,band.dx,CV_16S,1,0,aperture,1,0,cv::BORDER_REPLICATE);
+    cv::Sobel(band.padded,band.dy,CV_16S,0,1,aperture,1,0,cv::BORDER_REPLICATE);
+    // Gradient magnitude (L1) of rows yBegin-1 to yEnd: rows and columns outside image are zero
+    band.magnitude.assign((band.yEnd-band.yBegin+2)*magStep,0);
+    for(int y=gradientBegin;y<gradientEnd;y++)
+    {
+        const short *dx=band.dx.ptr<short>(y-gradientBegin+r)+r;
+        const short *dy=band.dy.ptr<short>(y-gradientBegin+r)+r;
+        int *mag=&band.magnitude[(y-band.yBegin+1)*magStep+1];
+        for(int j=0;j<cols;j++)
+            mag[j]=std::abs((int)dx[j])+std::abs((int)dy[j]);
+    }
+    // Non-maxima suppression (as in cv::Canny()): candidates above high threshold are edges
+    band.stack.clear();
+    for(int i=band.yBegin;i<band.yEnd;i++)
+    {
+        const short *dx=band.dx.ptr<short>(i-gradientBegin+r)+r;
+        const short *dy=band.dy.ptr<short>(i-gradientBegin+r)+r;
+        const int *mag=&band.magnitude[(i-band.yBegin+1)*magStep+1];
+        uchar *mapRow=map.ptr<uchar>(i+1)+1;
+        mapRow[-1]=mapRow[cols]=1;
+        for(int j=0;j<cols;j++)
+        {
+            int m=mag[j];
+            bool candidate=false;
+            if(m>low)
+            {
+                int xs=dx[j];
+                int ys=dy[j];
+                int x=std::abs(xs);
+                int y=std::abs(ys)<<CANNY_SHIFT;
+                int tg22x=x*CANNY_TG22;
+                if(y<tg22x)
+                    candidate=(m>mag[j-1])&&(m>=mag[j+1]);
+                else
+                {
+                    // (wraps around for very large gradients exactly as in cv::Canny())
+                    int tg67x=(int)((unsigned int)tg22x+((unsigned int)x<<(CANNY_SHIFT+1)));
+                    if(y>tg67x)
+                        candidate=(m>mag[j-magStep])&&(m>=mag[j+magStep]);
+                    else
+                    {
+                        int s=((xs^ys)<0) ? -1 : 1;
+                        candidate=(m>mag[j-magStep-s])&&(m>mag[j+magStep+s]);
+                    }
+                }
+            }
+            if(!candidate)
+                mapRow[j]=1;
+            else if(m>high)
+            {
+                mapRow[j]=2;
+                band.stack.push_back(mapRow+j);
+            }
+            else
+                mapRow[j]=0;
+        }
+    }
+    // Hysteresis within band
+    followEdges(band.stack,band.yBegin,band.yEnd);
+} // processBand()
+
+void ParallelCanny::followEdges(std::vector<uchar*> &stack, int yBegin, int yEnd)
+{
+    // Candidates connected to edges (8-connectivity) are edges: only rows yBegin to yEnd-1 are followed
+    int mapStep=(int)map.step;
+    uchar *first=map.ptr<uchar>(yBegin+1);
+    uchar *last=map.ptr<uchar>(yEnd+1);
+    const int offsets[8]={-1,1,-mapStep-1,-mapStep,-mapStep+1,mapStep-1,mapStep,mapStep+1};
+    while(!stack.empty())
+    {
+        uchar *m=stack.back();
+        stack.pop_back();
+        for(int k=0;k<8;k++)
+        {
+            uchar *n=m+offsets[k];
+            if((n>=first)&&(n<last)&&(*n==0))
+            {
+                *n=2;
+                stack.push_back(n);
+            }
+        }
+    }
+} // followEdges()
+
+void ParallelCanny::writeBand(int bandIndex)
+{
+    // Called concurrently for different bands
+    CannyBand &band=bands[bandIndex];
+    for(int y=band.yBegin;y<band.yEnd;y++)
+    {
+        const uchar *mapRow=map.ptr<uchar>(y+1)+1;
+        uchar *dst=currentDst.ptr<uchar>(y);
+        for(int j=0;j<currentDst.cols;j++)
+            dst[j]=(uchar)-(mapRow[j]>>1);
+    }
+} // writeBand()
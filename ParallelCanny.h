@@ -0,0 +1,83 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* ParallelCanny.h                                                      */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+
+
+#ifndef PARALLELCANNY_H
+#define PARALLELCANNY_H
+
+// Qt header files
+#include <QThreadPool>
+// OpenCV header files
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+// Workspace of a band of rows (kept between frames)
+struct CannyBand{
+    int yBegin;
+    int yEnd;
+    cv::Mat padded; // Source rows of band with halo (gradient rows above/below and Sobel aperture)
+    cv::Mat dx;
+    cv::Mat dy;
+    std::vector<int> magnitude; // Rows yBegin-1 to yEnd (zero outside image)
+    std::vector<uchar*> stack;
+};
+
+// Canny edge detection computed in bands of rows on a thread pool.
+// Output is identical to cvCanny() (L1 gradient): each band computes gradients, non-maxima suppression and
+// hysteresis within the band; edges are then followed across band borders in a second (serial) pass.
+class ParallelCanny
+{
+
+public:
+    ParallelCanny();
+    ~ParallelCanny();
+    void apply(const cv::Mat &src, cv::Mat &dst, double threshold1, double threshold2, int apertureSize);
+    void processBand(int bandIndex);
+    void writeBand(int bandIndex);
+private:
+    void followEdges(std::vector<uchar*> &stack, int yBegin, int yEnd);
+    QThreadPool threadPool;
+    cv::Mat currentSrc;
+    cv::Mat currentDst;
+    int low;
+    int high;
+    int aperture;
+    cv::Mat map; // 0: candidate, 1: no edge, 2: edge (one pixel border of 1)
+    std::vector<CannyBand> bands;
+    std::vector<uchar*> stack;
+};
+
+#endif // PARALLELCANNY_H
@@ -31,6 +31,7 @@
 /************************************************************************/
 
 #include "ProcessingSettingsDialog.h"
+#include "BackgroundModel.h"
 
 // Qt header files
 #include <QtGui>
@@ -38,17 +39,6 @@
 // Header file containing default values
 #include "DefaultValues.h"
 
-#include <opencv2/objdetect/objdetect.hpp>
-
-
-cv::String ConvertQString2CVString(const QString &qs)
-{
-    // QString->cv::String
-    // see: http://stackoverflow.com/questions/4214369/how-to-convert-qstring-to-stdstring
-    cv::String cs = qs.toUtf8().constData();
-    return cs;
-}
-
 ProcessingSettingsDialog::ProcessingSettingsDialog(QWidget *parent) : QDialog(parent)
 {
     // Setup dialog
@@ -60,11 +50,14 @@ ProcessingSettingsDialog::ProcessingSettingsDialog(QWidget *parent) : QDialog(pa
     connect(resetErodeToDefaultsButton,SIGNAL(released()),SLOT(resetErodeDialogToDefaults()));
     connect(resetFlipToDefaultsButton,SIGNAL(released()),SLOT(resetFlipDialogToDefaults()));
     connect(resetCannyToDefaultsButton,SIGNAL(released()),SLOT(resetCannyDialogToDefaults()));
+    connect(resetBackgroundToDefaultsButton,SIGNAL(released()),SLOT(resetBackgroundDialogToDefaults()));
     connect(resetFaceDetectToDefaultsButton,SIGNAL(released()),SLOT(resetFaceDetectToDefaults()));
     connect(applyButton,SIGNAL(released()),SLOT(updateStoredSettingsFromDialog()));
     connect(smoothTypeGroup,SIGNAL(buttonReleased(QAbstractButton*)),SLOT(smoothTypeChange(QAbstractButton*)));
+    connect(backgroundMethodGroup,SIGNAL(buttonReleased(QAbstractButton*)),SLOT(backgroundMethodChange(QAbstractButton*)));
     connect(chooseFacedetectCascadeFileButton,SIGNAL(released()),SLOT(chooseFacedetectCascadeFile()));
     connect(chooseFacedetectNestedCascadeFileButton,SIGNAL(released()),SLOT(chooseFacedetectNestedCascadeFile()));
+    connect(chooseFacedetectAdditionalCascadeFilesButton,SIGNAL(released()),SLOT(chooseFacedetectAdditionalCascadeFiles()));
     // dilateIterationsEdit input string validation
     QRegExp rx5("[1-9]\\d{0,1}"); // Integers 1 to 99
     QRegExpValidator *validator5 = new QRegExpValidator(rx5, 0);
@@ -85,6 +78,26 @@ ProcessingSettingsDialog::ProcessingSettingsDialog(QWidget *parent) : QDialog(pa
     QRegExp rx9("[3,5,7]\\d{0,0}"); // Integers 3,5,7
     QRegExpValidator *validator9 = new QRegExpValidator(rx9, 0);
     cannyApertureSizeEdit->setValidator(validator9);
+    // facedetectDetectionIntervalEdit input string validation
+    QRegExp rx10("[1-9]\\d{0,1}"); // Integers 1 to 99
+    QRegExpValidator *validator10 = new QRegExpValidator(rx10, 0);
+    facedetectDetectionIntervalEdit->setValidator(validator10);
+    // facedetectFullSweepIntervalEdit input string validation
+    QRegExp rx11("[1-9]\\d{0,1}"); // Integers 1 to 99
+    QRegExpValidator *validator11 = new QRegExpValidator(rx11, 0);
+    facedetectFullSweepIntervalEdit->setValidator(validator11);
+    // facedetectBudgetEdit input string validation
+    QRegExp rx12("[1-9]\\d{0,2}"); // Integers 1 to 999
+    QRegExpValidator *validator12 = new QRegExpValidator(rx12, 0);
+    facedetectBudgetEdit->setValidator(validator12);
+    // backgroundLearningRateEdit input string validation
+    QRegExp rx13("0\\.\\d{1,3}"); // Decimals 0.001 to 0.999
+    QRegExpValidator *validator13 = new QRegExpValidator(rx13, 0);
+    backgroundLearningRateEdit->setValidator(validator13);
+    // backgroundThresholdEdit input string validation
+    QRegExp rx14("[1-9]\\d{0,1}"); // Integers 1 to 99
+    QRegExpValidator *validator14 = new QRegExpValidator(rx14, 0);
+    backgroundThresholdEdit->setValidator(validator14);
     // Set dialog values to defaults
     resetAllDialogToDefaults();
     // Update processing settings in processingSettings structure and processingThread
@@ -123,14 +136,31 @@ void ProcessingSettingsDialog::updateStoredSettingsFromDialog()
     processingSettings.cannyThreshold1=cannyThresh1Edit->text().toDouble();
     processingSettings.cannyThreshold2=cannyThresh2Edit->text().toDouble();
     processingSettings.cannyApertureSize=cannyApertureSizeEdit->text().toInt();
+    // Background
+    if(backgroundMethodGroup->checkedButton()==(QAbstractButton*)backgroundRunningAverageButton)
+        processingSettings.backgroundMethod=BACKGROUND_RUNNING_AVERAGE;
+    else if(backgroundMethodGroup->checkedButton()==(QAbstractButton*)backgroundGaussianMixtureButton)
+        processingSettings.backgroundMethod=BACKGROUND_GAUSSIAN_MIXTURE;
+    processingSettings.backgroundLearningRate=backgroundLearningRateEdit->text().toDouble();
+    processingSettings.backgroundThreshold=backgroundThresholdEdit->text().toInt();
     // Facedetect
     processingSettings.facedetectScale=facedetectScaleEdit->text().toDouble();
     processingSettings.facedetectCascadeFilename=facedetectCascadeFilenameEdit->text();
-    if(!processingSettings.facedetectCascadeFile.load(ConvertQString2CVString(processingSettings.facedetectCascadeFilename)))
-        qDebug() << "ERROR: Can not open cascade file.";
     processingSettings.facedetectNestedCascadeFilename=facedetectNestedCasssscadeFilenameEdit->text();
-    if(processingSettings.facedetectNestedCascadeFile.load(ConvertQString2CVString(processingSettings.facedetectNestedCascadeFilename)))
-        qDebug() << "ERROR: Can not open nested cascade file.";
+    processingSettings.facedetectTrackingOn=facedetectTrackingCheckBox->isChecked();
+    processingSettings.facedetectDetectionInterval=facedetectDetectionIntervalEdit->text().toInt();
+    processingSettings.facedetectSearchRegionsOn=facedetectSearchRegionsCheckBox->isChecked();
+    processingSettings.facedetectFullSweepInterval=facedetectFullSweepIntervalEdit->text().toInt();
+    processingSettings.facedetectBudgetOn=facedetectBudgetCheckBox->isChecked();
+    processingSettings.facedetectBudget=facedetectBudgetEdit->text().toInt();
+    // Cascades are loaded once (in the background) and shared: only handles are stored in settings
+    processingSettings.facedetectCascade=CascadeCache::getCascade(processingSettings.facedetectCascadeFilename);
+    processingSettings.facedetectNestedCascade=CascadeCache::getCascade(processingSettings.facedetectNestedCascadeFilename);
+    // Additional cascades (file names separated by ';')
+    processingSettings.facedetectAdditionalCascadeFilenames=facedetectAdditionalCascadeFilenamesEdit->text().split(';',QString::SkipEmptyParts);
+    processingSettings.facedetectAdditionalCascades.clear();
+    for(int i=0;i<processingSettings.facedetectAdditionalCascadeFilenames.size();i++)
+        processingSettings.facedetectAdditionalCascades.append(CascadeCache::getCascade(processingSettings.facedetectAdditionalCascadeFilenames.at(i).trimmed()));
     // Update processing flags in processingThread
     emit newProcessingSettings(processingSettings);
 } // updateStoredSettingsFromDialog()
@@ -165,14 +195,42 @@ void ProcessingSettingsDialog::updateDialogSettingsFromStored()
     cannyThresh1Edit->setText(QString::number(processingSettings.cannyThreshold1));
     cannyThresh2Edit->setText(QString::number(processingSettings.cannyThreshold2));
     cannyApertureSizeEdit->setText(QString::number(processingSettings.cannyApertureSize));
+    // Background
+    if(processingSettings.backgroundMethod==BACKGROUND_RUNNING_AVERAGE)
+        backgroundRunningAverageButton->setChecked(true);
+    else if(processingSettings.backgroundMethod==BACKGROUND_GAUSSIAN_MIXTURE)
+        backgroundGaussianMixtureButton->setChecked(true);
+    backgroundLearningRateEdit->setText(QString::number(processingSettings.backgroundLearningRate));
+    backgroundThresholdEdit->setText(QString::number(processingSettings.backgroundThreshold));
     // Facedetct
     facedetectScaleEdit->setText(QString::number(processingSettings.facedetectScale));
     facedetectCascadeFilenameEdit->setText(processingSettings.facedetectCascadeFilename);
     facedetectNestedCasssscadeFilenameEdit->setText(processingSettings.facedetectNestedCascadeFilename);
+    facedetectAdditionalCascadeFilenamesEdit->setText(processingSettings.facedetectAdditionalCascadeFilenames.join(";"));
+    facedetectTrackingCheckBox->setChecked(processingSettings.facedetectTrackingOn);
+    facedetectDetectionIntervalEdit->setText(QString::number(processingSettings.facedetectDetectionInterval));
+    facedetectSearchRegionsCheckBox->setChecked(processingSettings.facedetectSearchRegionsOn);
+    facedetectFullSweepIntervalEdit->setText(QString::number(processingSettings.facedetectFullSweepInterval));
+    facedetectBudgetCheckBox->setChecked(processingSettings.facedetectBudgetOn);
+    facedetectBudgetEdit->setText(QString::number(processingSettings.facedetectBudget));
     // Enable/disable appropriate Smooth parameter inputs
     smoothTypeChange(smoothTypeGroup->checkedButton());
+    // Enable/disable appropriate Background parameter inputs
+    backgroundMethodChange(backgroundMethodGroup->checkedButton());
 } // updateDialogSettingsFromStored()
 
+void ProcessingSettingsDialog::setProcessingSettings(const ProcessingSettings &settings)
+{
+    // Settings of another camera are shown in dialog (not emitted)
+    processingSettings=settings;
+    updateDialogSettingsFromStored();
+} // setProcessingSettings()
+
+struct ProcessingSettings ProcessingSettingsDialog::getProcessingSettings()
+{
+    return processingSettings;
+} // getProcessingSettings()
+
 void ProcessingSettingsDialog::resetAllDialogToDefaults()
 {
     // Smooth
@@ -185,6 +243,8 @@ void ProcessingSettingsDialog::resetAllDialogToDefaults()
     resetFlipDialogToDefaults();
     // Canny
     resetCannyDialogToDefaults();
+    // Background
+    resetBackgroundDialogToDefaults();
     // Facedetect
     resetFaceDetectToDefaults();
 } // resetAllDialogToDefaults()
@@ -277,6 +337,12 @@ void ProcessingSettingsDialog::smoothTypeChange(QAbstractButton *input)
     }
 } // smoothTypeChange()
 
+void ProcessingSettingsDialog::backgroundMethodChange(QAbstractButton *input)
+{
+    // Threshold is only used by running average (Gaussian mixture matches pixels against component deviations)
+    backgroundThresholdEdit->setEnabled(input==(QAbstractButton*)backgroundRunningAverageButton);
+} // backgroundMethodChange()
+
 void ProcessingSettingsDialog::validateDialog()
 {
     // Local variables
@@ -341,11 +407,36 @@ void ProcessingSettingsDialog::validateDialog()
         cannyApertureSizeEdit->setText(QString::number(DEFAULT_CANNY_APERTURE_SIZE));
         inputEmpty=true;
     }
+    if(backgroundLearningRateEdit->text().isEmpty())
+    {
+        backgroundLearningRateEdit->setText(QString::number(DEFAULT_BACKGROUND_LEARNING_RATE));
+        inputEmpty=true;
+    }
+    if(backgroundThresholdEdit->text().isEmpty())
+    {
+        backgroundThresholdEdit->setText(QString::number(DEFAULT_BACKGROUND_THRESHOLD));
+        inputEmpty=true;
+    }
     if(facedetectScaleEdit->text().isEmpty())
     {
         facedetectScaleEdit->setText(QString::number(DEFAULT_FACEDETECT_SCALE));
         inputEmpty=true;
     }
+    if(facedetectDetectionIntervalEdit->text().isEmpty())
+    {
+        facedetectDetectionIntervalEdit->setText(QString::number(DEFAULT_FACEDETECT_DETECTION_INTERVAL));
+        inputEmpty=true;
+    }
+    if(facedetectFullSweepIntervalEdit->text().isEmpty())
+    {
+        facedetectFullSweepIntervalEdit->setText(QString::number(DEFAULT_FACEDETECT_FULL_SWEEP_INTERVAL));
+        inputEmpty=true;
+    }
+    if(facedetectBudgetEdit->text().isEmpty())
+    {
+        facedetectBudgetEdit->setText(QString::number(DEFAULT_FACEDETECT_BUDGET));
+        inputEmpty=true;
+    }
     // Check if any of the inputs were empty
     if(inputEmpty)
         QMessageBox::warning(this->parentWidget(),"WARNING:","One or more inputs empty.\n\nAutomatically set to default values.");
@@ -358,6 +449,12 @@ void ProcessingSettingsDialog::validateDialog()
         smoothParam3Edit->setText(QString::number(DEFAULT_SMOOTH_PARAM_3));
         QMessageBox::warning(this->parentWidget(),"ERROR:","Parameters 1 and 3 cannot BOTH be zero when the smoothing type is GAUSSIAN.\n\nAutomatically set to default values.");
     }
+    // Check for special parameter case when background learning rate is zero (model would never be updated)
+    if(backgroundLearningRateEdit->text().toDouble()<0.001)
+    {
+        backgroundLearningRateEdit->setText(QString::number(DEFAULT_BACKGROUND_LEARNING_RATE));
+        QMessageBox::warning(this->parentWidget(),"ERROR:","Background learning rate cannot be zero.\n\nAutomatically set to default value.");
+    }
 } // validateDialog()
 
 void ProcessingSettingsDialog::resetSmoothDialogToDefaults()
@@ -405,17 +502,36 @@ void ProcessingSettingsDialog::resetCannyDialogToDefaults()
     cannyApertureSizeEdit->setText(QString::number(DEFAULT_CANNY_APERTURE_SIZE));
 } // resetCannyDialogToDefaults()
 
+void ProcessingSettingsDialog::resetBackgroundDialogToDefaults()
+{
+    if(DEFAULT_BACKGROUND_METHOD==BACKGROUND_RUNNING_AVERAGE)
+        backgroundRunningAverageButton->setChecked(true);
+    else if(DEFAULT_BACKGROUND_METHOD==BACKGROUND_GAUSSIAN_MIXTURE)
+        backgroundGaussianMixtureButton->setChecked(true);
+    backgroundLearningRateEdit->setText(QString::number(DEFAULT_BACKGROUND_LEARNING_RATE));
+    backgroundThresholdEdit->setText(QString::number(DEFAULT_BACKGROUND_THRESHOLD));
+    // Enable/disable appropriate Background parameter inputs
+    backgroundMethodChange(backgroundMethodGroup->checkedButton());
+} // resetBackgroundDialogToDefaults()
+
 void ProcessingSettingsDialog::resetFaceDetectToDefaults()
 {
     facedetectScaleEdit->setText(QString::number(DEFAULT_FACEDETECT_SCALE));
     facedetectCascadeFilenameEdit->setText(QString::fromUtf8(DEFAULT_FACEDETECT_CASCADE_FILENAME));
     facedetectNestedCasssscadeFilenameEdit->setText(QString::fromUtf8(DEFAULT_FACEDETECT_NESTED_CASCADE_FILENAME));
+    facedetectAdditionalCascadeFilenamesEdit->setText(QString::fromUtf8(DEFAULT_FACEDETECT_ADDITIONAL_CASCADE_FILENAMES));
+    facedetectTrackingCheckBox->setChecked(DEFAULT_FACEDETECT_TRACKING_ON);
+    facedetectDetectionIntervalEdit->setText(QString::number(DEFAULT_FACEDETECT_DETECTION_INTERVAL));
+    facedetectSearchRegionsCheckBox->setChecked(DEFAULT_FACEDETECT_SEARCH_REGIONS_ON);
+    facedetectFullSweepIntervalEdit->setText(QString::number(DEFAULT_FACEDETECT_FULL_SWEEP_INTERVAL));
+    facedetectBudgetCheckBox->setChecked(DEFAULT_FACEDETECT_BUDGET_ON);
+    facedetectBudgetEdit->setText(QString::number(DEFAULT_FACEDETECT_BUDGET));
 } // resetFaceDetectToDefaults()
 
 void ProcessingSettingsDialog::chooseFacedetectCascadeFile()
 {
     QString fileName = QFileDialog::getOpenFileName(this,
-         tr("Open Front Face Cascade Classifier File"), ".", tr("XML Files (*.xml)"));
+         tr("Open Front Face Cascade Classifier File"), ".", tr("Cascade Files (*.xml *.bin)"));
     if(fileName.isNull())
     {
         fileName = QString::fromUtf8(DEFAULT_FACEDETECT_CASCADE_FILENAME);
@@ -426,10 +542,20 @@ void ProcessingSettingsDialog::chooseFacedetectCascadeFile()
 void ProcessingSettingsDialog::chooseFacedetectNestedCascadeFile()
 {
     QString fileName = QFileDialog::getOpenFileName(this,
-         tr("Open Nested Cascade Classifier File"), ".", tr("XML Files (*.xml)"));
+         tr("Open Nested Cascade Classifier File"), ".", tr("Cascade Files (*.xml *.bin)"));
     if(fileName.isNull())
     {
         fileName = QString::fromUtf8(DEFAULT_FACEDETECT_NESTED_CASCADE_FILENAME);
     }
     facedetectNestedCasssscadeFilenameEdit->setText(fileName);
 }
+
+void ProcessingSettingsDialog::chooseFacedetectAdditionalCascadeFiles()
+{
+    QStringList fileNames = QFileDialog::getOpenFileNames(this,
+         tr("Open Additional Cascade Classifier Files"), ".", tr("Cascade Files (*.xml *.bin)"));
+    // Keep current files if dialog was cancelled
+    if(fileNames.isEmpty())
+        return;
+    facedetectAdditionalCascadeFilenamesEdit->setText(fileNames.join(";"));
+} // chooseFacedetectAdditionalCascadeFiles()
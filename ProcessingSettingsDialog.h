@@ -43,6 +43,8 @@ class ProcessingSettingsDialog : public QDialog, private Ui::ProcessingSettingsD
 public:
     ProcessingSettingsDialog(QWidget *parent = 0);
     void updateDialogSettingsFromStored();
+    void setProcessingSettings(const ProcessingSettings &settings);
+    struct ProcessingSettings getProcessingSettings();
 private:
     ProcessingSettings processingSettings;
 public slots:
@@ -54,11 +56,14 @@ private slots:
     void resetErodeDialogToDefaults();
     void resetFlipDialogToDefaults();
     void resetCannyDialogToDefaults();
+    void resetBackgroundDialogToDefaults();
     void resetFaceDetectToDefaults();
     void validateDialog();
     void smoothTypeChange(QAbstractButton*);
+    void backgroundMethodChange(QAbstractButton*);
     void chooseFacedetectCascadeFile();
     void chooseFacedetectNestedCascadeFile();
+    void chooseFacedetectAdditionalCascadeFiles();
 signals:
     void newProcessingSettings(struct ProcessingSettings p_settings);
 };
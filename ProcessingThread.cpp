@@ -34,6 +34,7 @@
 #include "ProcessingThread.h"
 #include "ShowIplImage.h"
 #include "FaceDetect.h"
+#include "FaceDetectThread.h"
 
 // Qt header files
 #include <QDebug>
@@ -50,42 +51,90 @@ ProcessingThread::ProcessingThread(ImageBuffer *imageBuffer, int inputSourceWidt
     // Create IplImages
     currentFrameCopy=cvCreateImage(cvSize(inputSourceWidth,inputSourceHeight),IPL_DEPTH_8U,3);
     currentFrameCopyGrayscale=cvCreateImage(cvSize(inputSourceWidth,inputSourceHeight),IPL_DEPTH_8U,1);
+    // Display frame is created on demand (only when display is smaller than the input source)
+    displayFrame=NULL;
+    // Changed regions are processed in these buffers (motion gating)
+    regionBuffer=cvCreateImage(cvSize(inputSourceWidth,inputSourceHeight),IPL_DEPTH_8U,3);
+    regionBufferGrayscale=cvCreateImage(cvSize(inputSourceWidth,inputSourceHeight),IPL_DEPTH_8U,1);
+    // Create face detection thread (started/stopped together with this thread)
+    faceDetectThread=new FaceDetectThread();
+    // Detection results are also delivered by signal (emitted in face detection thread)
+    qRegisterMetaType<struct FaceDetectResults>("FaceDetectResults");
+    connect(faceDetectThread,SIGNAL(newFaceDetectResults(struct FaceDetectResults)),this,SIGNAL(newFaceDetectResults(struct FaceDetectResults)));
+    // Blob results are delivered by signal (emitted in this thread) and published with frame
+    qRegisterMetaType<struct BlobResults>("BlobResults");
     // Initialize variables
     stopped=false;
+    frameNumber=0;
+    publishedResultsFrameNumber=-1;
+    blobResults.frameNumber=-1;
     sampleNo=0;
     fpsSum=0;
     avgFPS=0;
     fps.clear();
-    // Initialize processing flags
-    grayscaleOn=false;
-    smoothOn=false;
-    dilateOn=false;
-    erodeOn=false;
-    flipOn=false;
-    cannyOn=false;
-    facedetectOn=false;
+    statistics.captureRate=0;
+    statistics.processingRate=0;
+    statistics.currentSizeOfBuffer=0;
+    statistics.nSkippedFrames=0;
+    statistics.nDroppedFrames=0;
+    statistics.latency=0;
+    statistics.detectionOn=false;
+    statistics.detectionRate=0;
+    statistics.detectionParameters=faceDetectThread->getParameters();
+    statistics.motionFraction=-1;
+    statistics.nBlobs=-1;
     // Initialize task flags
     setROIFlag=false;
     resetROIFlag=false;
+    // Initialize processing flags
+    stagedSnapshot.flags.grayscaleOn=false;
+    stagedSnapshot.flags.smoothOn=false;
+    stagedSnapshot.flags.dilateOn=false;
+    stagedSnapshot.flags.erodeOn=false;
+    stagedSnapshot.flags.flipOn=false;
+    stagedSnapshot.flags.cannyOn=false;
+    stagedSnapshot.flags.facedetectOn=false;
+    stagedSnapshot.flags.motionGatingOn=DEFAULT_MOTION_GATING_ON;
+    stagedSnapshot.flags.backgroundOn=false;
+    stagedSnapshot.flags.blobsOn=false;
     // Initialize processing settings
-    smoothType=DEFAULT_SMOOTH_TYPE;
-    smoothParam1=DEFAULT_SMOOTH_PARAM_1;
-    smoothParam2=DEFAULT_SMOOTH_PARAM_2;
-    smoothParam3=DEFAULT_SMOOTH_PARAM_3;
-    smoothParam4=DEFAULT_SMOOTH_PARAM_4;
-    dilateNumberOfIterations=DEFAULT_DILATE_ITERATIONS;
-    erodeNumberOfIterations=DEFAULT_ERODE_ITERATIONS;
-    flipMode=DEFAULT_FLIP_MODE;
-    cannyThreshold1=DEFAULT_CANNY_THRESHOLD_1;
-    cannyThreshold2=DEFAULT_CANNY_THRESHOLD_2;
-    cannyApertureSize=DEFAULT_CANNY_APERTURE_SIZE;
-    facedetectScale=DEFAULT_FACEDETECT_SCALE;
-    facedetectCascadeFile.load(DEFAULT_FACEDETECT_CASCADE_FILENAME);
-    facedetectNestedCascadeFile.load(DEFAULT_FACEDETECT_NESTED_CASCADE_FILENAME);
+    stagedSnapshot.settings.smoothType=DEFAULT_SMOOTH_TYPE;
+    stagedSnapshot.settings.smoothParam1=DEFAULT_SMOOTH_PARAM_1;
+    stagedSnapshot.settings.smoothParam2=DEFAULT_SMOOTH_PARAM_2;
+    stagedSnapshot.settings.smoothParam3=DEFAULT_SMOOTH_PARAM_3;
+    stagedSnapshot.settings.smoothParam4=DEFAULT_SMOOTH_PARAM_4;
+    stagedSnapshot.settings.dilateNumberOfIterations=DEFAULT_DILATE_ITERATIONS;
+    stagedSnapshot.settings.erodeNumberOfIterations=DEFAULT_ERODE_ITERATIONS;
+    stagedSnapshot.settings.flipMode=DEFAULT_FLIP_MODE;
+    stagedSnapshot.settings.cannyThreshold1=DEFAULT_CANNY_THRESHOLD_1;
+    stagedSnapshot.settings.cannyThreshold2=DEFAULT_CANNY_THRESHOLD_2;
+    stagedSnapshot.settings.cannyApertureSize=DEFAULT_CANNY_APERTURE_SIZE;
+    stagedSnapshot.settings.backgroundMethod=DEFAULT_BACKGROUND_METHOD;
+    stagedSnapshot.settings.backgroundLearningRate=DEFAULT_BACKGROUND_LEARNING_RATE;
+    stagedSnapshot.settings.backgroundThreshold=DEFAULT_BACKGROUND_THRESHOLD;
+    stagedSnapshot.settings.facedetectScale=DEFAULT_FACEDETECT_SCALE;
+    stagedSnapshot.settings.facedetectCascadeFilename=QString::fromUtf8(DEFAULT_FACEDETECT_CASCADE_FILENAME);
+    stagedSnapshot.settings.facedetectNestedCascadeFilename=QString::fromUtf8(DEFAULT_FACEDETECT_NESTED_CASCADE_FILENAME);
+    stagedSnapshot.settings.facedetectCascade=CascadeCache::getCascade(stagedSnapshot.settings.facedetectCascadeFilename);
+    stagedSnapshot.settings.facedetectNestedCascade=CascadeCache::getCascade(stagedSnapshot.settings.facedetectNestedCascadeFilename);
+    stagedSnapshot.settings.facedetectAdditionalCascadeFilenames=QString::fromUtf8(DEFAULT_FACEDETECT_ADDITIONAL_CASCADE_FILENAMES).split(';',QString::SkipEmptyParts);
+    for(int i=0;i<stagedSnapshot.settings.facedetectAdditionalCascadeFilenames.size();i++)
+        stagedSnapshot.settings.facedetectAdditionalCascades.append(CascadeCache::getCascade(stagedSnapshot.settings.facedetectAdditionalCascadeFilenames.at(i)));
+    stagedSnapshot.settings.facedetectTrackingOn=DEFAULT_FACEDETECT_TRACKING_ON;
+    stagedSnapshot.settings.facedetectDetectionInterval=DEFAULT_FACEDETECT_DETECTION_INTERVAL;
+    stagedSnapshot.settings.facedetectSearchRegionsOn=DEFAULT_FACEDETECT_SEARCH_REGIONS_ON;
+    stagedSnapshot.settings.facedetectFullSweepInterval=DEFAULT_FACEDETECT_FULL_SWEEP_INTERVAL;
+    stagedSnapshot.settings.facedetectBudgetOn=DEFAULT_FACEDETECT_BUDGET_ON;
+    stagedSnapshot.settings.facedetectBudget=DEFAULT_FACEDETECT_BUDGET;
+    // Initialize display size (no downscaling until the display size is known)
+    stagedSnapshot.displaySize=QSize(inputSourceWidth,inputSourceHeight);
+    // Processing thread starts with a private copy of the initial snapshot
+    snapshot=new ProcessingSnapshot(stagedSnapshot);
     // Initialize currentROI variable
     currentROI=cvRect(0,0,inputSourceWidth,inputSourceHeight);
     // Store original ROI
     originalROI=currentROI;
+    statistics.currentROI=QRect(currentROI.x,currentROI.y,currentROI.width,currentROI.height);
 } // ProcessingThread constructor
 
 ProcessingThread::~ProcessingThread()
@@ -95,10 +144,28 @@ ProcessingThread::~ProcessingThread()
         cvReleaseImage(&currentFrameCopy);
     if(currentFrameCopyGrayscale!=NULL)
         cvReleaseImage(&currentFrameCopyGrayscale);
+    if(displayFrame!=NULL)
+        cvReleaseImage(&displayFrame);
+    if(regionBuffer!=NULL)
+        cvReleaseImage(&regionBuffer);
+    if(regionBufferGrayscale!=NULL)
+        cvReleaseImage(&regionBufferGrayscale);
+    // Delete face detection thread
+    delete faceDetectThread;
+    // Free frame not taken by GUI thread (if it exists)
+    delete latestFrame.fetchAndStoreOrdered(NULL);
+    // Free snapshots and task data
+    delete snapshot;
+    delete publishedSnapshot.fetchAndStoreOrdered(NULL);
+    delete publishedTaskData.fetchAndStoreOrdered(NULL);
 } // ProcessingThread destructor
 
 void ProcessingThread::run()
 {
+    // Local variables
+    FaceDetectResults faceDetectResults;
+    // Start face detection thread: detection runs at its own pace (display path never waits for it)
+    faceDetectThread->start(QThread::LowPriority);
     while(1)
     {
         /////////////////////////////////
@@ -119,18 +186,52 @@ void ProcessingThread::run()
         // Start timer (used to calculate processing rate)
         t.start();
         // Get frame from queue
-        IplImage* currentFrame = imageBuffer->getFrame();
+        qint64 captureTimestamp;
+        IplImage* currentFrame = imageBuffer->getFrame(&captureTimestamp);
         // Check that grabbed frame is not a NULL image
         if(currentFrame!=NULL)
         {
             // Set ROI of grabbed frame
             cvSetImageROI(currentFrame,currentROI);
+            frameNumber++;
+            // Pick up settings and task data published since the last frame (whole frame is processed if any)
+            bool forceProcessing=updateMembersFromPublished();
+            // Processing flags and settings are unchanged until the next frame boundary
+            ProcessingFlags flags=snapshot->flags;
+            // Luma capture: frame holds grayscale plane only (there is no colour plane: grayscale processing is always ON)
+            bool lumaFrame=(currentFrame->nChannels==1);
+            if(lumaFrame)
+                flags.grayscaleOn=true;
+            ProcessingSettings &settings=snapshot->settings;
+            // Motion gating: find regions changed since they were last processed
+            // (previous output is kept if nothing has changed, only changed regions are processed if few tiles have changed;
+            //  background model has to learn from every frame)
+            bool frameChanged=true;
+            bool regionsOnly=false;
+            double motionFraction=-1;
+            if(flags.motionGatingOn&&!flags.backgroundOn)
+            {
+                motionFraction=motionDetector.detect(cv::Mat(currentFrame),motionRegions);
+                if(!forceProcessing)
+                {
+                    frameChanged=(motionFraction>0.);
+                    regionsOnly=frameChanged&&(motionFraction<=DEFAULT_MOTION_FULL_FRAME_FRACTION);
+                }
+            }
+            else
+                motionDetector.reset();
+            // Background model is learned again from scratch when background subtraction is turned ON
+            if(!flags.backgroundOn)
+                backgroundModel.reset();
             // Make copy of current frame (processing will be performed on this copy)
-            cvCopy(currentFrame,currentFrameCopy);
+            if(frameChanged&&!regionsOnly)
+                cvCopy(currentFrame,lumaFrame?currentFrameCopyGrayscale:currentFrameCopy);
+            // No detections are published with frame unless face detection is ON
+            faceDetectResults.frameNumber=-1;
+            faceDetectResults.detections.clear();
             ///////////////////
             // PERFORM TASKS //
             ///////////////////
-            updateMembersMutex.lock();
             if(resetROIFlag)
                 resetROI();
             else if(setROIFlag)
@@ -140,92 +241,125 @@ void ProcessingThread::run()
             ////////////////////////////////////
             else
             {
-                // Grayscale conversion
-                if(grayscaleOn)
-                    cvCvtColor(currentFrameCopy,currentFrameCopyGrayscale,CV_BGR2GRAY);
-                // Smooth
-                if(smoothOn)
-                {
-                    if(grayscaleOn)
-                        cvSmooth(currentFrameCopyGrayscale,currentFrameCopyGrayscale,
-                                 smoothType,smoothParam1,smoothParam2,smoothParam3,smoothParam4);
-                    else
-                        cvSmooth(currentFrameCopy,currentFrameCopy,
-                                 smoothType,smoothParam1,smoothParam2,smoothParam3,smoothParam4);
-                } // if
-                // Dilate
-                if(dilateOn)
+                // Process changed regions only (output of unchanged regions is kept) or whole frame
+                if(regionsOnly)
+                    processRegions(currentFrame,flags,settings);
+                else if(frameChanged)
+                    processFrame(lumaFrame?NULL:currentFrameCopy,currentFrameCopyGrayscale,flags,settings);
+                // Blob extraction (on binary output of Canny or Background Subtraction)
+                // Unchanged frame: previous blobs still apply
+                if(flags.blobsOn&&(flags.cannyOn||flags.backgroundOn))
                 {
-                    if(grayscaleOn)
-                        cvDilate(currentFrameCopyGrayscale,currentFrameCopyGrayscale,NULL,
-                                 dilateNumberOfIterations);
-                    else
-                        cvDilate(currentFrameCopy,currentFrameCopy,NULL,
-                                 dilateNumberOfIterations);
-                } // if
-                // Erode
-                if(erodeOn)
+                    if(frameChanged)
+                    {
+                        blobExtractor.extract(cv::Mat(currentFrameCopyGrayscale),cv::Point(currentROI.x,currentROI.y),blobResults.blobs);
+                        blobResults.frameNumber=frameNumber;
+                        emit newBlobResults(blobResults);
+                    }
+                }
+                else
                 {
-                    if(grayscaleOn)
-                        cvErode(currentFrameCopyGrayscale,currentFrameCopyGrayscale,NULL,
-                                erodeNumberOfIterations);
-                    else
-                        cvErode(currentFrameCopy,currentFrameCopy,NULL,
-                                erodeNumberOfIterations);
-                } // if
-                // Flip
-                if(flipOn)
-                {
-                    if(grayscaleOn)
-                        cvFlip(currentFrameCopyGrayscale,NULL,flipMode);
-                    else
-                        cvFlip(currentFrameCopy,NULL,flipMode);
-                } // if
-                // Canny edge detection
-                if(cannyOn)
-                {
-                    // Frame must be converted to grayscale first if grayscale conversion is OFF
-                    if(!grayscaleOn)
-                        cvCvtColor(currentFrameCopy,currentFrameCopyGrayscale,CV_BGR2GRAY);
-
-                    cvCanny(currentFrameCopyGrayscale,currentFrameCopyGrayscale,
-                            cannyThreshold1,cannyThreshold2,
-                            cannyApertureSize);
-                } // if
+                    blobResults.frameNumber=-1;
+                    blobResults.blobs.clear();
+                }
                 // facedetect
-                if(facedetectOn)
+                if(flags.facedetectOn)
                 {
-                    if(facedetectCascadeFile.empty())
+                    // Cascades may still be loading in the background: detection starts once loaded
+                    if(!settings.facedetectCascade->isLoading()&&!settings.facedetectCascade->isLoaded())
                         qDebug() << "ERROR: cascade file missed.";
-                    if(facedetectNestedCascadeFile.empty())
+                    if(!settings.facedetectNestedCascade->isLoading()&&!settings.facedetectNestedCascade->isLoaded())
                         qDebug() << "ERROR: nested cascade file missed.";
-                    faceDetect(currentFrameCopy, facedetectCascadeFile, facedetectNestedCascadeFile, facedetectScale);
+                    // Hand frame over to face detection thread (frame is dropped if detection is still busy)
+                    // Grayscale plane is handed over if it holds the (processed) grayscale frame: no colour conversion needed
+                    // Unchanged frames are not handed over (previous results still apply)
+                    if(frameChanged)
+                    {
+                        if(flags.grayscaleOn&&!flags.cannyOn&&!flags.backgroundOn)
+                            faceDetectThread->addFrame(currentFrameCopyGrayscale,frameNumber,settings);
+                        else if(lumaFrame)
+                            faceDetectThread->addFrame(currentFrame,frameNumber,settings);
+                        else
+                            faceDetectThread->addFrame(currentFrameCopy,frameNumber,settings);
+                    }
+                    // Most recent detection results are published with frame (results older than maximum age are dropped)
+                    faceDetectResults=faceDetectThread->getResults();
+                    if((faceDetectResults.frameNumber>=0)&&
+                       (QDateTime::currentMSecsSinceEpoch()-faceDetectResults.timestamp>DEFAULT_FACEDETECT_RESULTS_MAX_AGE))
+                        faceDetectResults.detections.clear();
                 } // if
+                else
+                    faceDetectThread->clearResults();
             } // else
             ////////////////////////////////////
             // PERFORM IMAGE PROCESSING ABOVE //
             ////////////////////////////////////
 
             //// Convert IplImage to QImage: Show grayscale frame
-            //// (if either Grayscale or Canny processing modes are ON)
-            if(grayscaleOn||cannyOn)
-                frame=IplImageToQImage(currentFrameCopyGrayscale);
-            //// Convert IplImage to QImage: Show BGR frame
-            else
-                frame=IplImageToQImage(currentFrameCopy);
-            updateMembersMutex.unlock();
+            //// (if either Grayscale, Canny or Background Subtraction processing modes are ON)
+            //// Frame is downscaled to display size here so the GUI thread never handles more pixels than it shows
+            //// Flip is done by the conversion (frame is processed unflipped: no extra pass over the frame)
+            //// Only ROI is flipped (in place, as by cvFlip() on ROI of processed frame)
+            //// (unchanged frame: previous QImage is still valid)
+            if(frameChanged)
+            {
+                IplImage *displayed;
+                if(flags.grayscaleOn||flags.cannyOn||flags.backgroundOn)
+                    displayed=scaleForDisplay(currentFrameCopyGrayscale);
+                //// Convert IplImage to QImage: Show BGR frame
+                else
+                    displayed=scaleForDisplay(currentFrameCopy);
+                double scale=(double)displayed->width/inputSourceWidth;
+                QRect flipRect(cvRound(currentROI.x*scale),cvRound(currentROI.y*scale),
+                               cvRound(currentROI.width*scale),cvRound(currentROI.height*scale));
+                frame=IplImageToQImage(displayed,flags.flipOn,settings.flipMode,flipRect);
+            }
+            // Publish new frame (QImage) with detections: replaces any frame not yet taken by GUI thread
+            // (unchanged frame is only published again if new detection results have arrived)
+            if(frameChanged||(faceDetectResults.frameNumber!=publishedResultsFrameNumber))
+            {
+                ProcessedFrame *processedFrame=new ProcessedFrame;
+                processedFrame->image=frame;
+                processedFrame->frameNumber=frameNumber;
+                processedFrame->displayScale=(double)frame.width()/inputSourceWidth;
+                processedFrame->flipOn=flags.flipOn;
+                processedFrame->flipMode=settings.flipMode;
+                processedFrame->flipRect=QRect(currentROI.x,currentROI.y,currentROI.width,currentROI.height);
+                processedFrame->faceDetectResults=faceDetectResults;
+                processedFrame->blobResults=blobResults;
+                publishedResultsFrameNumber=faceDetectResults.frameNumber;
+                ProcessedFrame *previousFrame=latestFrame.fetchAndStoreOrdered(processedFrame);
+                if(previousFrame!=NULL)
+                {
+                    skippedFrames.ref();
+                    delete previousFrame;
+                }
+            }
             // Update statistics
             updateFPS(processingTime);
-            currentSizeOfBuffer=imageBuffer->getSizeOfImageBuffer();
-            // Inform controller of new frame (QImage)
-            emit newFrame(frame);
-            // Release IplImage
+            statisticsMutex.lock();
+            statistics.processingRate=avgFPS;
+            statistics.currentSizeOfBuffer=imageBuffer->getSizeOfImageBuffer();
+            statistics.nSkippedFrames=(int)skippedFrames;
+            statistics.latency=(int)(QDateTime::currentMSecsSinceEpoch()-captureTimestamp);
+            statistics.currentROI=QRect(currentROI.x,currentROI.y,currentROI.width,currentROI.height);
+            statistics.detectionOn=flags.facedetectOn;
+            statistics.detectionRate=faceDetectThread->getAvgFPS();
+            statistics.detectionParameters=faceDetectThread->getParameters();
+            statistics.motionFraction=motionFraction;
+            statistics.nBlobs=(blobResults.frameNumber>=0) ? (int)blobResults.blobs.size() : -1;
+            statisticsMutex.unlock();
+            // Release IplImage (frame is returned to its owner if it was not copied into buffer)
             if(currentFrame!=NULL)
-                cvReleaseImage(&currentFrame);
+                imageBuffer->releaseFrame(currentFrame);
         } // if
         else
             qDebug() << "ERROR: Processing thread received a NULL image.";
     } // while
+    // Stop face detection thread
+    faceDetectThread->stopFaceDetectThread();
+    faceDetectThread->wait();
+    faceDetectThread->clearResults();
     qDebug() << "Stopping processing thread...";
 } // run()
 
@@ -260,6 +394,135 @@ void ProcessingThread::stopProcessingThread()
     stoppedMutex.unlock();
 } // stopProcessingThread()
 
+void ProcessingThread::processFrame(IplImage *image, IplImage *imageGrayscale, ProcessingFlags &flags, ProcessingSettings &settings)
+{
+    // Grayscale conversion (no colour plane if frame was captured as luma: grayscale plane already holds frame)
+    if(flags.grayscaleOn&&(image!=NULL))
+        cvCvtColor(image,imageGrayscale,CV_BGR2GRAY);
+    // Smooth
+    if(flags.smoothOn)
+    {
+        if(flags.grayscaleOn)
+            cvSmooth(imageGrayscale,imageGrayscale,
+                     settings.smoothType,settings.smoothParam1,settings.smoothParam2,settings.smoothParam3,settings.smoothParam4);
+        else
+            cvSmooth(image,image,
+                     settings.smoothType,settings.smoothParam1,settings.smoothParam2,settings.smoothParam3,settings.smoothParam4);
+    } // if
+    // Background subtraction (grayscale plane is replaced by foreground mask)
+    if(flags.backgroundOn)
+    {
+        // Frame must be converted to grayscale first if grayscale conversion is OFF
+        if(!flags.grayscaleOn)
+            cvCvtColor(image,imageGrayscale,CV_BGR2GRAY);
+        cv::Mat mask(imageGrayscale);
+        backgroundModel.apply(mask,mask,settings.backgroundMethod,
+                              settings.backgroundLearningRate,settings.backgroundThreshold);
+    } // if
+    // Dilate
+    if(flags.dilateOn)
+    {
+        if(flags.grayscaleOn||flags.backgroundOn)
+            cvDilate(imageGrayscale,imageGrayscale,NULL,
+                     settings.dilateNumberOfIterations);
+        else
+            cvDilate(image,image,NULL,
+                     settings.dilateNumberOfIterations);
+    } // if
+    // Erode
+    if(flags.erodeOn)
+    {
+        if(flags.grayscaleOn||flags.backgroundOn)
+            cvErode(imageGrayscale,imageGrayscale,NULL,
+                    settings.erodeNumberOfIterations);
+        else
+            cvErode(image,image,NULL,
+                    settings.erodeNumberOfIterations);
+    } // if
+    // Canny edge detection
+    if(flags.cannyOn)
+    {
+        // Frame must be converted to grayscale first if grayscale conversion and background subtraction are OFF
+        if(!flags.grayscaleOn&&!flags.backgroundOn)
+            cvCvtColor(image,imageGrayscale,CV_BGR2GRAY);
+        // Computed in bands of rows in parallel (output identical to cvCanny())
+        cv::Mat edges(imageGrayscale);
+        parallelCanny.apply(edges,edges,
+                            settings.cannyThreshold1,settings.cannyThreshold2,
+                            settings.cannyApertureSize);
+    } // if
+} // processFrame()
+
+void ProcessingThread::processRegions(IplImage *source, ProcessingFlags &flags, ProcessingSettings &settings)
+{
+    // Local variables
+    IplImage regionFrame, regionFrameGrayscale;
+    // Pixels of changed region depend on pixels up to this distance: region is processed with a margin
+    int margin=getProcessingMargin(flags,settings);
+    cv::Rect roiRect(0,0,currentROI.width,currentROI.height);
+    // Luma capture: source frame is grayscale (there is no colour plane)
+    bool lumaFrame=(source->nChannels==1);
+    for(std::vector<cv::Rect>::const_iterator r=motionRegions.begin();r!=motionRegions.end();r++)
+    {
+        cv::Rect outer=cv::Rect(r->x-margin,r->y-margin,r->width+2*margin,r->height+2*margin)&roiRect;
+        // Region images use the region buffers (images have the size of the region: pixels outside it are not read)
+        cvInitImageHeader(&regionFrame,cvSize(outer.width,outer.height),IPL_DEPTH_8U,3);
+        cvSetData(&regionFrame,regionBuffer->imageData,regionBuffer->widthStep);
+        cvInitImageHeader(&regionFrameGrayscale,cvSize(outer.width,outer.height),IPL_DEPTH_8U,1);
+        cvSetData(&regionFrameGrayscale,regionBufferGrayscale->imageData,regionBufferGrayscale->widthStep);
+        // Copy region (with margin) from source frame and process it
+        cvSetImageROI(source,cvRect(currentROI.x+outer.x,currentROI.y+outer.y,outer.width,outer.height));
+        if(lumaFrame)
+        {
+            cvCopy(source,&regionFrameGrayscale);
+            processFrame(NULL,&regionFrameGrayscale,flags,settings);
+        }
+        else
+        {
+            cvCopy(source,&regionFrame);
+            processFrame(&regionFrame,&regionFrameGrayscale,flags,settings);
+        }
+        // Copy region (without margin) to output: colour plane is always updated (it is also handed over to face detection),
+        // grayscale plane if either Grayscale, Canny or Background Subtraction processing modes are ON
+        CvRect inner=cvRect(r->x-outer.x,r->y-outer.y,r->width,r->height);
+        CvRect output=cvRect(currentROI.x+r->x,currentROI.y+r->y,r->width,r->height);
+        if(!lumaFrame)
+        {
+            cvSetImageROI(&regionFrame,inner);
+            cvSetImageROI(currentFrameCopy,output);
+            cvCopy(&regionFrame,currentFrameCopy);
+            cvResetImageROI(&regionFrame);
+        }
+        if(flags.grayscaleOn||flags.cannyOn||flags.backgroundOn)
+        {
+            cvSetImageROI(&regionFrameGrayscale,inner);
+            cvSetImageROI(currentFrameCopyGrayscale,output);
+            cvCopy(&regionFrameGrayscale,currentFrameCopyGrayscale);
+            cvResetImageROI(&regionFrameGrayscale);
+        }
+    }
+    // Restore ROIs
+    cvSetImageROI(source,currentROI);
+    cvSetImageROI(currentFrameCopy,currentROI);
+    cvSetImageROI(currentFrameCopyGrayscale,currentROI);
+} // processRegions()
+
+int ProcessingThread::getProcessingMargin(ProcessingFlags &flags, ProcessingSettings &settings)
+{
+    // Sum of the distances each enabled processing step reads pixels from
+    int margin=1;
+    if(flags.smoothOn)
+        margin+=qMax(qMax(settings.smoothParam1,settings.smoothParam2)/2,
+                     cvCeil(3*qMax(settings.smoothParam3,settings.smoothParam4)));
+    if(flags.dilateOn)
+        margin+=settings.dilateNumberOfIterations;
+    if(flags.erodeOn)
+        margin+=settings.erodeNumberOfIterations;
+    if(flags.cannyOn)
+        margin+=settings.cannyApertureSize/2+1+DEFAULT_MOTION_CANNY_MARGIN;
+    return margin;
+} // getProcessingMargin()
+
 void ProcessingThread::setROI()
 {
     // Set area outside ROI in currentFrameCopy to blue
@@ -271,6 +534,11 @@ void ProcessingThread::setROI()
     // Set new ROIs
     cvSetImageROI(currentFrameCopy, currentROI);
     cvSetImageROI(currentFrameCopyGrayscale, currentROI);
+    // Detection results, blobs, motion reference and background model refer to previous ROI
+    faceDetectThread->clearResults();
+    blobResults.blobs.clear();
+    motionDetector.reset();
+    backgroundModel.reset();
     qDebug() << "ROI successfully SET.";
     // Reset setROIOn flag to FALSE
     setROIFlag=false;
@@ -283,64 +551,118 @@ void ProcessingThread::resetROI()
     cvResetImageROI(currentFrameCopyGrayscale);
     // Set ROI back to original ROI
     currentROI=originalROI;
+    // Detection results, blobs, motion reference and background model refer to previous ROI
+    faceDetectThread->clearResults();
+    blobResults.blobs.clear();
+    motionDetector.reset();
+    backgroundModel.reset();
     qDebug() << "ROI successfully RESET.";
     // Reset resetROIOn flag to FALSE
     resetROIFlag=false;
 } // resetROI()
 
+IplImage* ProcessingThread::scaleForDisplay(IplImage *source)
+{
+    // Local variables
+    double scale;
+    int width, height;
+    // Return source image unchanged if it fits inside the display
+    QSize displaySize=snapshot->displaySize;
+    if((displaySize.width()<=0)||(displaySize.height()<=0)||
+       ((source->width<=displaySize.width())&&(source->height<=displaySize.height())))
+        return source;
+    // Calculate display frame dimensions (aspect ratio is preserved)
+    scale=qMin((double)displaySize.width()/source->width,(double)displaySize.height()/source->height);
+    width=qMax(1,cvRound(source->width*scale));
+    height=qMax(1,cvRound(source->height*scale));
+    // (Re)create display frame if dimensions or number of channels have changed
+    if((displayFrame==NULL)||(displayFrame->width!=width)||(displayFrame->height!=height)||
+       (displayFrame->nChannels!=source->nChannels))
+    {
+        if(displayFrame!=NULL)
+            cvReleaseImage(&displayFrame);
+        displayFrame=cvCreateImage(cvSize(width,height),source->depth,source->nChannels);
+    }
+    // Whole frame is displayed: temporarily remove ROI of source image
+    if(source->roi!=NULL)
+    {
+        CvRect roi=cvGetImageROI(source);
+        cvResetImageROI(source);
+        cvResize(source,displayFrame,CV_INTER_AREA);
+        cvSetImageROI(source,roi);
+    }
+    else
+        cvResize(source,displayFrame,CV_INTER_AREA);
+    return displayFrame;
+} // scaleForDisplay()
+
+void ProcessingThread::publishSnapshot()
+{
+    // Called in GUI thread: publish copy of staged snapshot (replaces any snapshot not yet picked up)
+    delete publishedSnapshot.fetchAndStoreOrdered(new ProcessingSnapshot(stagedSnapshot));
+} // publishSnapshot()
+
+bool ProcessingThread::updateMembersFromPublished()
+{
+    // Called in processing thread at frame boundary: take ownership of newly published snapshot
+    // (returns TRUE if a snapshot or task data has been taken)
+    ProcessingSnapshot *newSnapshot=publishedSnapshot.fetchAndStoreOrdered(NULL);
+    if(newSnapshot!=NULL)
+    {
+        delete snapshot;
+        snapshot=newSnapshot;
+    }
+    // Take newly published task data
+    TaskData *taskData=publishedTaskData.fetchAndStoreOrdered(NULL);
+    if(taskData!=NULL)
+    {
+        setROIFlag=taskData->setROIFlag;
+        resetROIFlag=taskData->resetROIFlag;
+        selectionBox.x=taskData->selectionBox.left();
+        selectionBox.y=taskData->selectionBox.top();
+        selectionBox.width=taskData->selectionBox.width();
+        selectionBox.height=taskData->selectionBox.height();
+        delete taskData;
+    }
+    return (newSnapshot!=NULL)||(taskData!=NULL);
+} // updateMembersFromPublished()
+
 void ProcessingThread::updateProcessingFlags(struct ProcessingFlags processingFlags)
 {
-    QMutexLocker locker(&updateMembersMutex);
-    this->grayscaleOn=processingFlags.grayscaleOn;
-    this->smoothOn=processingFlags.smoothOn;
-    this->dilateOn=processingFlags.dilateOn;
-    this->erodeOn=processingFlags.erodeOn;
-    this->flipOn=processingFlags.flipOn;
-    this->cannyOn=processingFlags.cannyOn;
-    this->facedetectOn=processingFlags.facedetectOn;
+    stagedSnapshot.flags=processingFlags;
+    publishSnapshot();
 } // updateProcessingFlags()
 
 void ProcessingThread::updateProcessingSettings(struct ProcessingSettings processingSettings)
 {
-    QMutexLocker locker(&updateMembersMutex);
-    this->smoothType=processingSettings.smoothType;
-    this->smoothParam1=processingSettings.smoothParam1;
-    this->smoothParam2=processingSettings.smoothParam2;
-    this->smoothParam3=processingSettings.smoothParam3;
-    this->smoothParam4=processingSettings.smoothParam4;
-    this->dilateNumberOfIterations=processingSettings.dilateNumberOfIterations;
-    this->erodeNumberOfIterations=processingSettings.erodeNumberOfIterations;
-    this->flipMode=processingSettings.flipMode;
-    this->cannyThreshold1=processingSettings.cannyThreshold1;
-    this->cannyThreshold2=processingSettings.cannyThreshold2;
-    this->cannyApertureSize=processingSettings.cannyApertureSize;
-    this->facedetectScale=processingSettings.facedetectScale;
-    this->facedetectCascadeFile=processingSettings.facedetectCascadeFile;
-    this->facedetectNestedCascadeFile=processingSettings.facedetectNestedCascadeFile;
+    stagedSnapshot.settings=processingSettings;
+    publishSnapshot();
 } // updateProcessingSettings()
 
 void ProcessingThread::updateTaskData(struct TaskData taskData)
 {
-    QMutexLocker locker(&updateMembersMutex);
-    this->setROIFlag=taskData.setROIFlag;
-    this->resetROIFlag=taskData.resetROIFlag;
-    this->selectionBox.x=taskData.selectionBox.left();
-    this->selectionBox.y=taskData.selectionBox.top();
-    this->selectionBox.width=taskData.selectionBox.width();
-    this->selectionBox.height=taskData.selectionBox.height();
+    delete publishedTaskData.fetchAndStoreOrdered(new TaskData(taskData));
 } // updateTaskData()
 
+void ProcessingThread::updateDisplaySize(QSize displaySize)
+{
+    stagedSnapshot.displaySize=displaySize;
+    publishSnapshot();
+} // updateDisplaySize()
+
 int ProcessingThread::getAvgFPS()
 {
     return avgFPS;
 } // getAvgFPS()
 
-int ProcessingThread::getCurrentSizeOfBuffer()
+struct ThreadStatistics ProcessingThread::getStatistics()
 {
-    return currentSizeOfBuffer;
-} // getCurrentSizeOfBuffer()
+    QMutexLocker locker(&statisticsMutex);
+    return statistics;
+} // getStatistics()
 
-CvRect ProcessingThread::getCurrentROI()
+ProcessedFrame* ProcessingThread::takeFrame()
 {
-    return currentROI;
-} // getCurrentROI();
+    // Returns NULL if no new frame has been published since the last call (caller takes ownership)
+    return latestFrame.fetchAndStoreOrdered(NULL);
+} // takeFrame()
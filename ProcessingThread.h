@@ -34,15 +34,19 @@
 #define PROCESSINGTHREAD_H
 
 #include "Structures.h"
+#include "MotionDetector.h"
+#include "BackgroundModel.h"
+#include "BlobExtractor.h"
+#include "ParallelCanny.h"
 
 // Qt header files
 #include <QThread>
 #include <QtGui>
 // OpenCV header files
 #include <opencv/highgui.h>
-#include <opencv2/objdetect/objdetect.hpp>
 
 class ImageBuffer;
+class FaceDetectThread;
 
 class ProcessingThread : public QThread
 {
@@ -53,22 +57,41 @@ public:
     ~ProcessingThread();
     void stopProcessingThread();
     int getAvgFPS();
-    int getCurrentSizeOfBuffer();
-    CvRect getCurrentROI();
+    struct ThreadStatistics getStatistics();
+    ProcessedFrame* takeFrame();
 private:
     void updateFPS(int);
     void setROI();
     void resetROI();
+    IplImage* scaleForDisplay(IplImage *source);
+    void processFrame(IplImage *image, IplImage *imageGrayscale, ProcessingFlags &flags, ProcessingSettings &settings);
+    void processRegions(IplImage *source, ProcessingFlags &flags, ProcessingSettings &settings);
+    int getProcessingMargin(ProcessingFlags &flags, ProcessingSettings &settings);
+    void publishSnapshot();
+    bool updateMembersFromPublished();
     ImageBuffer *imageBuffer;
     volatile bool stopped;
     int inputSourceWidth;
     int inputSourceHeight;
-    int currentSizeOfBuffer;
     IplImage *currentFrameCopy;
     IplImage *currentFrameCopyGrayscale;
+    IplImage *displayFrame;
+    IplImage *regionBuffer;
+    IplImage *regionBufferGrayscale;
+    MotionDetector motionDetector;
+    BackgroundModel backgroundModel;
+    BlobExtractor blobExtractor;
+    ParallelCanny parallelCanny;
+    BlobResults blobResults;
+    std::vector<cv::Rect> motionRegions;
+    int publishedResultsFrameNumber;
+    FaceDetectThread *faceDetectThread;
+    int frameNumber;
     CvRect originalROI;
     CvRect currentROI;
     QImage frame;
+    QAtomicPointer<ProcessedFrame> latestFrame;
+    QAtomicInt skippedFrames;
     QTime t;
     int processingTime;
     QQueue<int> fps;
@@ -76,42 +99,28 @@ private:
     int sampleNo;
     int avgFPS;
     QMutex stoppedMutex;
-    QMutex updateMembersMutex;
-    // Processing flags
-    bool grayscaleOn;
-    bool smoothOn;
-    bool dilateOn;
-    bool erodeOn;
-    bool flipOn;
-    bool cannyOn;
-    bool facedetectOn;
-    // Processing settings
-    int smoothType;
-    int smoothParam1;
-    int smoothParam2;
-    double smoothParam3;
-    double smoothParam4;
-    int dilateNumberOfIterations;
-    int erodeNumberOfIterations;
-    int flipMode;
-    double cannyThreshold1;
-    double cannyThreshold2;
-    int cannyApertureSize;
-    double facedetectScale;
-    cv::CascadeClassifier facedetectCascadeFile;
-    cv::CascadeClassifier facedetectNestedCascadeFile;
+    QMutex statisticsMutex;
+    // Statistics (snapshot updated once per frame)
+    ThreadStatistics statistics;
+    // Processing flags/settings: staged in GUI thread and published to processing thread as immutable snapshots
+    ProcessingSnapshot stagedSnapshot;
+    QAtomicPointer<ProcessingSnapshot> publishedSnapshot;
+    ProcessingSnapshot *snapshot;
     // Task data
+    QAtomicPointer<TaskData> publishedTaskData;
     bool setROIFlag;
     bool resetROIFlag;
     CvRect selectionBox;
 protected:
     void run();
-private slots:
+public slots:
     void updateProcessingFlags(struct ProcessingFlags);
     void updateProcessingSettings(struct ProcessingSettings);
     void updateTaskData(struct TaskData);
+    void updateDisplaySize(QSize);
 signals:
-    void newFrame(const QImage &frame);
+    void newFaceDetectResults(struct FaceDetectResults faceDetectResults);
+    void newBlobResults(struct BlobResults blobResults);
 };
 
 #endif // PROCESSINGTHREAD_H
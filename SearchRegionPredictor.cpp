@@ -0,0 +1,121 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* SearchRegionPredictor.cpp                                            */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "SearchRegionPredictor.h"
+
+// OpenCV header files
+#include <opencv2/imgproc/imgproc.hpp>
+// Header file containing default values
+#include "DefaultValues.h"
+
+SearchRegionPredictor::SearchRegionPredictor()
+{
+    detectionsSinceFullSweep=0;
+} // SearchRegionPredictor constructor
+
+void SearchRegionPredictor::reset()
+{
+    previousImage.release();
+    previousFaces.clear();
+    detectionsSinceFullSweep=0;
+} // reset()
+
+bool SearchRegionPredictor::predict(const cv::Mat &image, int fullSweepInterval, std::vector<SearchRegion> &regions)
+{
+    // Full sweep if there is no previous image (of the same size) or if a full sweep is due
+    bool fullSweep=(previousImage.size()!=image.size())||(detectionsSinceFullSweep+1>=fullSweepInterval);
+    regions.clear();
+    if(fullSweep)
+        detectionsSinceFullSweep=0;
+    else
+    {
+        cv::Rect imageRect(0,0,image.cols,image.rows);
+        // Regions around previous detections: object size is restricted to the neighbourhood of the previous size
+        for(std::vector<cv::Rect>::const_iterator r=previousFaces.begin();r!=previousFaces.end();r++)
+        {
+            SearchRegion region;
+            region.rect=cv::Rect(r->x-r->width/2,r->y-r->height/2,2*r->width,2*r->height)&imageRect;
+            region.minSize=cv::Size(cvRound(r->width*DEFAULT_FACEDETECT_REGION_MIN_SIZE_FACTOR),
+                                    cvRound(r->height*DEFAULT_FACEDETECT_REGION_MIN_SIZE_FACTOR));
+            region.maxSize=cv::Size(cvRound(r->width*DEFAULT_FACEDETECT_REGION_MAX_SIZE_FACTOR),
+                                    cvRound(r->height*DEFAULT_FACEDETECT_REGION_MAX_SIZE_FACTOR));
+            regions.push_back(region);
+        }
+        // Regions with motion since the previous detection (new faces may appear here at any size)
+        addMotionRegions(image,regions);
+        detectionsSinceFullSweep++;
+    }
+    // Store image (used to find motion regions at next detection)
+    image.copyTo(previousImage);
+    return !fullSweep;
+} // predict()
+
+void SearchRegionPredictor::update(const std::vector<cv::Rect> &faces)
+{
+    previousFaces=faces;
+} // update()
+
+void SearchRegionPredictor::addMotionRegions(const cv::Mat &image, std::vector<SearchRegion> &regions)
+{
+    // Local variables
+    std::vector<std::vector<cv::Point> > contours;
+    int cellSize=DEFAULT_FACEDETECT_MOTION_CELL_SIZE;
+
+    // Image too small to be divided into cells
+    if((image.cols<cellSize)||(image.rows<cellSize))
+        return;
+    // Changed pixels
+    cv::absdiff(image,previousImage,difference);
+    cv::threshold(difference,difference,DEFAULT_FACEDETECT_MOTION_THRESHOLD,255,cv::THRESH_BINARY);
+    // Fraction of changed pixels per cell (area interpolation averages each cell)
+    cv::resize(difference,cells,cv::Size(image.cols/cellSize,image.rows/cellSize),0,0,cv::INTER_AREA);
+    cv::threshold(cells,cells,255*DEFAULT_FACEDETECT_MOTION_CELL_FRACTION,255,cv::THRESH_BINARY);
+    // Join neighbouring cells (also adds a margin of one cell around each region)
+    cv::dilate(cells,cells,cv::Mat());
+    cv::findContours(cells,contours,CV_RETR_EXTERNAL,CV_CHAIN_APPROX_SIMPLE);
+    // Convert cell regions to image regions
+    double scaleX=(double)image.cols/cells.cols;
+    double scaleY=(double)image.rows/cells.rows;
+    for(std::vector<std::vector<cv::Point> >::const_iterator contour=contours.begin();contour!=contours.end();contour++)
+    {
+        cv::Rect cellRect=cv::boundingRect(cv::Mat(*contour));
+        SearchRegion region;
+        region.rect=cv::Rect(cvFloor(cellRect.x*scaleX),cvFloor(cellRect.y*scaleY),
+                             cvCeil(cellRect.width*scaleX),cvCeil(cellRect.height*scaleY))&
+                    cv::Rect(0,0,image.cols,image.rows);
+        region.minSize=cv::Size();
+        region.maxSize=cv::Size();
+        regions.push_back(region);
+    }
+} // addMotionRegions()
@@ -0,0 +1,69 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* SearchRegionPredictor.h                                              */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef SEARCHREGIONPREDICTOR_H
+#define SEARCHREGIONPREDICTOR_H
+
+// OpenCV header files
+#include <opencv2/core/core.hpp>
+
+#include <vector>
+
+// SearchRegion structure definition (object size range is restricted per region)
+struct SearchRegion{
+    cv::Rect rect;
+    cv::Size minSize;
+    cv::Size maxSize;
+};
+
+// Predicts where faces are likely to be found: regions around previous detections plus regions with motion
+// (a full-frame sweep is requested periodically so that new faces outside these regions are still found)
+class SearchRegionPredictor
+{
+
+public:
+    SearchRegionPredictor();
+    void reset();
+    bool predict(const cv::Mat &image, int fullSweepInterval, std::vector<SearchRegion> &regions);
+    void update(const std::vector<cv::Rect> &faces);
+private:
+    void addMotionRegions(const cv::Mat &image, std::vector<SearchRegion> &regions);
+    cv::Mat previousImage;
+    cv::Mat difference;
+    cv::Mat cells;
+    std::vector<cv::Rect> previousFaces;
+    int detectionsSinceFullSweep;
+};
+
+#endif // SEARCHREGIONPREDICTOR_H
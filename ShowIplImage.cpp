@@ -32,11 +32,53 @@
 
 #include "ShowIplImage.h"
 
-QImage IplImageToQImage(const IplImage *iplImage)
+// Copies n pixels of a row (src advances by srcStep pixels: -1 copies mirrored): 3-channel pixels are swapped from BGR to RGB
+static inline void copyPixels(uchar *dst, const uchar *src, int n, int srcStep, int nChannels)
+{
+    if(nChannels == 1)
+        for (int x=0; x<n; x++)
+            dst[x] = src[x*srcStep];
+    else
+        for (int x=0; x<n; x++, dst+=3)
+        {
+            const uchar *pixel = src + 3*x*srcStep;
+            dst[0] = pixel[2];
+            dst[1] = pixel[1];
+            dst[2] = pixel[0];
+        }
+} // copyPixels()
+
+// Converts image to QImage in a single pass, flipping pixels of flipRect in place
+static void convertFlipped(const IplImage *iplImage, QImage &img, QRect flipRect, bool horizontal, bool vertical)
+{
+    int n = iplImage->nChannels;
+    const uchar *buffer = (const uchar*)iplImage->imageData;
+    int left = flipRect.x();
+    int right = flipRect.x() + flipRect.width();
+    for (int y=0; y<iplImage->height; y++)
+    {
+        const uchar *row = buffer + iplImage->widthStep*y;
+        uchar *dst = img.scanLine(y);
+        // Rows of flipRect: pixels of flipRect are taken from mirrored row/column
+        bool inside = (y >= flipRect.y()) && (y < flipRect.y() + flipRect.height());
+        const uchar *flippedRow = (inside && vertical) ? buffer + iplImage->widthStep*(2*flipRect.y() + flipRect.height() - 1 - y) : row;
+        bool mirrored = inside && horizontal;
+        copyPixels(dst, row, left, 1, n);
+        copyPixels(dst + n*left, flippedRow + n*(mirrored ? right-1 : left), right-left, mirrored ? -1 : 1, n);
+        copyPixels(dst + n*right, row + n*right, iplImage->width-right, 1, n);
+    }
+} // convertFlipped()
+
+QImage IplImageToQImage(const IplImage *iplImage, bool flipOn, int flipMode, QRect flipRect)
 {
     // Local variables
     int height = iplImage->height;
     int width = iplImage->width;
+    // Flip is done while converting (flipMode as in cvFlip(): 0 around x-axis, 1 around y-axis, -1 around both axes)
+    // Only flipRect is flipped (in place, as cvFlip() flips the ROI of an image): whole image if flipRect is null
+    bool horizontal = flipOn && (flipMode != 0);
+    bool vertical = flipOn && (flipMode <= 0);
+    flipRect = flipRect.isNull() ? QRect(0, 0, width, height) : flipRect.intersected(QRect(0, 0, width, height));
     // PIXEL DEPTH=8-bits unsigned, NO. OF CHANNELS=1
     if(iplImage->depth == IPL_DEPTH_8U && iplImage->nChannels == 1)
     {
@@ -49,13 +91,28 @@ QImage IplImageToQImage(const IplImage *iplImage)
         // Create QImage with same dimensions as input IplImage
         QImage img(qImageBuffer, width, height, QImage::Format_Indexed8);
         img.setColorTable(colorTable);
-        return img;
+        // Return deep copy: QImage must remain valid after the IplImage is overwritten
+        if(flipOn)
+        {
+            QImage flipped(width, height, QImage::Format_Indexed8);
+            flipped.setColorTable(colorTable);
+            convertFlipped(iplImage, flipped, flipRect, horizontal, vertical);
+            return flipped;
+        }
+        return img.copy();
     }
     // PIXEL DEPTH=8-bits unsigned, NO. OF CHANNELS=3
     else if(iplImage->depth == IPL_DEPTH_8U && iplImage->nChannels == 3)
     {
         // Copy input IplImage
         const uchar *qImageBuffer = (const uchar*)iplImage->imageData;
+        if(flipOn)
+        {
+            // Swap BGR to RGB and flip in a single pass
+            QImage img(width, height, QImage::Format_RGB888);
+            convertFlipped(iplImage, img, flipRect, horizontal, vertical);
+            return img;
+        }
         // Create QImage with same dimensions as input IplImage
         QImage img(qImageBuffer, width, height, QImage::Format_RGB888);
         return img.rgbSwapped();
@@ -39,6 +39,6 @@
 // OpenCV header files
 #include <opencv/highgui.h>
 
-QImage IplImageToQImage(const IplImage*);
+QImage IplImageToQImage(const IplImage*, bool flipOn=false, int flipMode=0, QRect flipRect=QRect());
 
 #endif // SHOWIPLIMAGE_H
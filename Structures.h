@@ -33,9 +33,12 @@
 #ifndef STRUCTURES_H
 #define STRUCTURES_H
 
+#include "CascadeCache.h"
+
 // Qt header files
 #include <QtGui>
-#include <opencv2/objdetect/objdetect.hpp>
+
+#include <vector>
 
 // ProcessingSettings structure definition
 struct ProcessingSettings{
@@ -50,11 +53,22 @@ struct ProcessingSettings{
     double cannyThreshold1;
     double cannyThreshold2;
     int cannyApertureSize;
+    int backgroundMethod;
+    double backgroundLearningRate;
+    int backgroundThreshold;
     double facedetectScale;
     QString facedetectCascadeFilename;
     QString facedetectNestedCascadeFilename;
-    cv::CascadeClassifier facedetectCascadeFile;
-    cv::CascadeClassifier facedetectNestedCascadeFile;
+    CascadeHandle facedetectCascade;
+    CascadeHandle facedetectNestedCascade;
+    QStringList facedetectAdditionalCascadeFilenames;
+    QList<CascadeHandle> facedetectAdditionalCascades;
+    bool facedetectTrackingOn;
+    int facedetectDetectionInterval;
+    bool facedetectSearchRegionsOn;
+    int facedetectFullSweepInterval;
+    bool facedetectBudgetOn;
+    int facedetectBudget;
 };
 
 // ProcessingFlags structure definition
@@ -66,6 +80,73 @@ struct ProcessingFlags{
     bool flipOn;
     bool cannyOn;
     bool facedetectOn;
+    bool motionGatingOn;
+    bool backgroundOn;
+    bool blobsOn;
+};
+
+// ProcessingSnapshot structure definition
+// (published to processing thread as a whole and never modified afterwards)
+struct ProcessingSnapshot{
+    ProcessingFlags flags;
+    ProcessingSettings settings;
+    QSize displaySize;
+};
+
+// DetectionParameters structure definition (detector parameters currently in use)
+struct DetectionParameters{
+    double scale;
+    double scaleFactor;
+    int minSize;
+    int detectionInterval;
+};
+
+// FaceDetection structure definition (rectangles in frame coordinates, ROI offset included)
+struct FaceDetection{
+    int cascadeIndex; // 0: face cascade, >0: additional cascade
+    cv::Rect face;
+    std::vector<cv::Rect> nestedObjects;
+};
+
+// FaceDetectWorkspace structure definition
+// (per-thread scratch images: reallocated only when resolution changes)
+struct FaceDetectWorkspace{
+    cv::Mat gray;
+    cv::Mat smallImg;
+};
+
+// FaceDetectResults structure definition
+struct FaceDetectResults{
+    int frameNumber;
+    qint64 timestamp;
+    int detectionTime; // ms
+    std::vector<FaceDetection> detections;
+};
+
+// Blob structure definition (connected component of binary output, in frame coordinates, ROI offset included)
+struct Blob{
+    cv::Rect boundingBox;
+    int area; // Number of pixels
+    cv::Point2f centroid;
+};
+
+// BlobResults structure definition
+struct BlobResults{
+    int frameNumber;
+    std::vector<Blob> blobs;
+};
+
+// ProcessedFrame structure definition
+// (frame published to GUI thread together with most recent detections: drawn at display time)
+struct ProcessedFrame{
+    QImage image;
+    int frameNumber;
+    double displayScale; // Displayed image size / frame size
+    bool flipOn; // Image is flipped (flipMode as in cvFlip()): detections and blobs are not
+    int flipMode;
+    QRect flipRect; // Flipped region of image (ROI) in frame coordinates
+    FaceDetectResults faceDetectResults;
+    BlobResults blobResults;
 };
 
 // TaskData structure definition
@@ -75,6 +156,40 @@ struct TaskData{
     bool resetROIFlag;
 };
 
+// ThreadStatistics structure definition
+struct ThreadStatistics{
+    int captureRate;
+    int processingRate;
+    int currentSizeOfBuffer;
+    int nSkippedFrames;
+    int nDroppedFrames; // frames dropped by capture (oldest frames replaced in full image buffer, undecodable frames)
+    int latency; // ms from grab to end of processing
+    QRect currentROI;
+    bool detectionOn;
+    int detectionRate;
+    DetectionParameters detectionParameters;
+    double motionFraction;
+    int nBlobs; // -1 if blob extraction is OFF
+};
+
+// CaptureMode structure definition (0 or empty: driver default)
+struct CaptureMode{
+    int width;
+    int height;
+    double fps;
+    QString fourcc; // Pixel format (e.g. MJPG, YUYV)
+    int decodeScale; // MJPG frames (V4L2 capture) are decoded at 1/N of frame size [1,2,4,8]
+};
+
+// CameraSettings structure definition (one per camera pipeline)
+struct CameraSettings{
+    int deviceNumber;
+    int imageBufferSize;
+    bool lumaOn; // Luma plane only (frames are always grayscale)
+    bool v4l2On; // Capture through V4L2 (Linux)
+    CaptureMode mode;
+};
+
 // MouseData structure definition
 struct MouseData{
     QRect selectionBox;
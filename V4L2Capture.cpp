@@ -0,0 +1,545 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* V4L2Capture.cpp                                                      */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#include "V4L2Capture.h"
+
+// Qt header files
+#include <QDebug>
+#include <QString>
+// OpenCV header files
+#include <opencv2/imgproc/imgproc.hpp>
+// Header file containing default values
+#include "DefaultValues.h"
+
+#ifdef __linux__
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/videodev2.h>
+
+// ioctl() is restarted if it was interrupted by a signal
+static int xioctl(int fd, unsigned long request, void *arg)
+{
+    int r;
+    do
+        r=ioctl(fd,request,arg);
+    while((r==-1)&&(errno==EINTR));
+    return r;
+} // xioctl()
+#endif
+
+V4L2Capture::V4L2Capture() : nQueued(0), fd(-1), width(0), height(0), fps(0), pixelFormat(0), bytesPerLine(0), lumaOn(false), streaming(false)
+{
+} // V4L2Capture constructor
+
+V4L2Capture::~V4L2Capture()
+{
+    close();
+} // V4L2Capture destructor
+
+bool V4L2Capture::open(int deviceNumber, bool lumaOn, int nBuffers, const CaptureMode &mode)
+{
+    close();
+    // Any available camera: first device which can be opened
+    if(deviceNumber<0)
+    {
+        for(int i=0;i<DEFAULT_CAPTURE_MAX_DEVICES;i++)
+        {
+            if(openDevice(i,lumaOn,nBuffers,mode))
+                return true;
+        }
+        return false;
+    }
+    return openDevice(deviceNumber,lumaOn,nBuffers,mode);
+} // open()
+
+bool V4L2Capture::openDevice(int deviceNumber, bool lumaOn, int nBuffers, const CaptureMode &mode)
+{
+#ifdef __linux__
+    this->lumaOn=lumaOn;
+    QString deviceName=QString("/dev/video%1").arg(deviceNumber);
+    fd=::open(deviceName.toLocal8Bit().constData(),O_RDWR|O_NONBLOCK);
+    if(fd<0)
+    {
+        // Missing devices are skipped silently (any available camera)
+        if(errno!=ENOENT)
+            qDebug() << "ERROR: Could not open" << deviceName;
+        return false;
+    }
+    // Device must support video capture with streaming I/O
+    struct v4l2_capability capability;
+    memset(&capability,0,sizeof(capability));
+    if((xioctl(fd,VIDIOC_QUERYCAP,&capability)==-1)||
+       !(capability.capabilities&V4L2_CAP_VIDEO_CAPTURE)||!(capability.capabilities&V4L2_CAP_STREAMING))
+    {
+        qDebug() << "ERROR:" << deviceName << "is not a V4L2 streaming capture device.";
+        close();
+        return false;
+    }
+    // Request requested pixel format (if any), else a pixel format which can be handed out without conversion, YUYV otherwise
+    // (frame size is kept unless a frame size is requested)
+    struct v4l2_format format;
+    memset(&format,0,sizeof(format));
+    format.type=V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if(xioctl(fd,VIDIOC_G_FMT,&format)==-1)
+    {
+        qDebug() << "ERROR: Could not get format of" << deviceName;
+        close();
+        return false;
+    }
+    if((mode.width>0)&&(mode.height>0))
+    {
+        format.fmt.pix.width=mode.width;
+        format.fmt.pix.height=mode.height;
+        format.fmt.pix.bytesperline=0;
+    }
+    unsigned int formats[]={lumaOn ? V4L2_PIX_FMT_GREY : V4L2_PIX_FMT_BGR24,V4L2_PIX_FMT_YUYV};
+    int nFormats=2;
+    if(mode.fourcc.size()==4)
+    {
+        QByteArray fourcc=mode.fourcc.toLatin1();
+        formats[0]=v4l2_fourcc(fourcc[0],fourcc[1],fourcc[2],fourcc[3]);
+        nFormats=1;
+    }
+    for(int i=0;i<nFormats;i++)
+    {
+        struct v4l2_format requested=format;
+        requested.fmt.pix.pixelformat=formats[i];
+        requested.fmt.pix.field=V4L2_FIELD_ANY;
+        if((xioctl(fd,VIDIOC_S_FMT,&requested)==0)&&(requested.fmt.pix.pixelformat==formats[i]))
+            break;
+    }
+    // Driver may refuse to change format: current format is used if it is supported
+    if(xioctl(fd,VIDIOC_G_FMT,&format)==-1)
+    {
+        qDebug() << "ERROR: Could not get format of" << deviceName;
+        close();
+        return false;
+    }
+    pixelFormat=format.fmt.pix.pixelformat;
+    int bytesPerPixel;
+    if(pixelFormat==V4L2_PIX_FMT_GREY)
+        bytesPerPixel=1;
+    else if(pixelFormat==V4L2_PIX_FMT_YUYV)
+        bytesPerPixel=2;
+    else if(pixelFormat==V4L2_PIX_FMT_BGR24)
+        bytesPerPixel=3;
+    // Compressed frames are decoded by caller
+    else if(isCompressed())
+        bytesPerPixel=0;
+    else
+    {
+        qDebug() << "ERROR: Pixel format of" << deviceName << "is not supported (GREY, YUYV, BGR24 or MJPG required).";
+        close();
+        return false;
+    }
+    width=format.fmt.pix.width;
+    height=format.fmt.pix.height;
+    bytesPerLine=(format.fmt.pix.bytesperline>0) ? format.fmt.pix.bytesperline : width*bytesPerPixel;
+    if(((mode.width>0)&&(mode.width!=width))||((mode.height>0)&&(mode.height!=height)))
+        qDebug() << "WARNING: Frame size" << mode.width << "x" << mode.height << "not supported by" << deviceName << ":" << width << "x" << height << "used.";
+    // Request frame rate (driver picks nearest supported frame interval)
+    struct v4l2_streamparm parameters;
+    memset(&parameters,0,sizeof(parameters));
+    parameters.type=V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if((mode.fps>0)&&(xioctl(fd,VIDIOC_G_PARM,&parameters)==0)&&(parameters.parm.capture.capability&V4L2_CAP_TIMEPERFRAME))
+    {
+        parameters.parm.capture.timeperframe.numerator=1000;
+        parameters.parm.capture.timeperframe.denominator=(unsigned int)(mode.fps*1000+0.5);
+        xioctl(fd,VIDIOC_S_PARM,&parameters);
+    }
+    fps=0;
+    if((xioctl(fd,VIDIOC_G_PARM,&parameters)==0)&&(parameters.parm.capture.timeperframe.numerator>0))
+        fps=(double)parameters.parm.capture.timeperframe.denominator/parameters.parm.capture.timeperframe.numerator;
+    // Allocate driver buffers
+    struct v4l2_requestbuffers request;
+    memset(&request,0,sizeof(request));
+    request.count=nBuffers;
+    request.type=V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    request.memory=V4L2_MEMORY_MMAP;
+    if((xioctl(fd,VIDIOC_REQBUFS,&request)==-1)||(request.count<2))
+    {
+        qDebug() << "ERROR: Could not allocate driver buffers of" << deviceName;
+        close();
+        return false;
+    }
+    if((int)request.count<nBuffers)
+        qDebug() << "WARNING: Driver allocated" << request.count << "of" << nBuffers << "buffers: capture waits for frames to be released.";
+    // Map driver buffers and create frame handed out for each buffer
+    buffers.resize(request.count);
+    for(unsigned int i=0;i<buffers.size();i++)
+    {
+        buffers[i].start=NULL;
+        buffers[i].length=0;
+        buffers[i].frame=NULL;
+        buffers[i].queued=false;
+    }
+    for(unsigned int i=0;i<buffers.size();i++)
+    {
+        struct v4l2_buffer buffer;
+        memset(&buffer,0,sizeof(buffer));
+        buffer.type=V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buffer.memory=V4L2_MEMORY_MMAP;
+        buffer.index=i;
+        void *start=MAP_FAILED;
+        if(xioctl(fd,VIDIOC_QUERYBUF,&buffer)==0)
+            start=mmap(NULL,buffer.length,PROT_READ|PROT_WRITE,MAP_SHARED,fd,buffer.m.offset);
+        if(start==MAP_FAILED)
+        {
+            qDebug() << "ERROR: Could not map driver buffers of" << deviceName;
+            close();
+            return false;
+        }
+        buffers[i].start=start;
+        buffers[i].length=buffer.length;
+        // Zero copy: frame header on mapped buffer
+        if(isZeroCopy())
+        {
+            buffers[i].frame=cvCreateImageHeader(cvSize(width,height),IPL_DEPTH_8U,bytesPerPixel);
+            cvSetData(buffers[i].frame,start,bytesPerLine);
+        }
+        // Frame is converted from mapped buffer
+        else if(!isCompressed())
+            buffers[i].frame=cvCreateImage(cvSize(width,height),IPL_DEPTH_8U,lumaOn ? 1 : 3);
+    }
+    // Queue all buffers and start capture
+    for(unsigned int i=0;i<buffers.size();i++)
+    {
+        if(!queueBuffer(i))
+        {
+            close();
+            return false;
+        }
+    }
+    enum v4l2_buf_type type=V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if(xioctl(fd,VIDIOC_STREAMON,&type)==-1)
+    {
+        qDebug() << "ERROR: Could not start capture on" << deviceName;
+        close();
+        return false;
+    }
+    streaming=true;
+    qDebug() << "V4L2 capture on" << deviceName << ":" << width << "x" << height << "@" << fps << "fps," << buffers.size() << "buffers"
+             << (isZeroCopy() ? "(zero copy)." : (isCompressed() ? "(compressed)." : "(converted)."));
+    return true;
+#else
+    Q_UNUSED(deviceNumber);
+    Q_UNUSED(lumaOn);
+    Q_UNUSED(nBuffers);
+    Q_UNUSED(mode);
+    qDebug() << "ERROR: V4L2 capture is only available on Linux.";
+    return false;
+#endif
+} // openDevice()
+
+void V4L2Capture::close()
+{
+    QMutexLocker locker(&mutex);
+#ifdef __linux__
+    // Stop capture
+    if(streaming)
+    {
+        enum v4l2_buf_type type=V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        xioctl(fd,VIDIOC_STREAMOFF,&type);
+        streaming=false;
+    }
+    // Release frames and unmap driver buffers (all frames must have been released)
+    for(unsigned int i=0;i<buffers.size();i++)
+    {
+        if(buffers[i].frame!=NULL)
+        {
+            if(isZeroCopy())
+                cvReleaseImageHeader(&buffers[i].frame);
+            else
+                cvReleaseImage(&buffers[i].frame);
+        }
+        if(buffers[i].start!=NULL)
+            munmap(buffers[i].start,buffers[i].length);
+    }
+    buffers.clear();
+    nQueued=0;
+    // Close device (driver buffers are freed)
+    if(fd>=0)
+    {
+        ::close(fd);
+        fd=-1;
+    }
+#endif
+} // close()
+
+bool V4L2Capture::isOpened()
+{
+    return streaming;
+} // isOpened()
+
+IplImage* V4L2Capture::dequeueFrame(int timeout)
+{
+#ifdef __linux__
+    int index=dequeueBuffer(timeout,NULL,NULL);
+    if(index<0)
+        return NULL;
+    V4L2Buffer &b=buffers[index];
+    // ROI set by previous consumer of frame is removed
+    cvResetImageROI(b.frame);
+    // Convert frame from mapped buffer (if it can not be handed out as it is; buffer is not owned by driver)
+    if(!isZeroCopy())
+    {
+        cv::Mat frame(b.frame);
+        if(pixelFormat==V4L2_PIX_FMT_YUYV)
+        {
+            cv::Mat source(height,width,CV_8UC2,b.start,bytesPerLine);
+            // Luma is the first channel of every pixel
+            if(lumaOn)
+            {
+                int fromTo[]={0,0};
+                cv::mixChannels(&source,1,&frame,1,fromTo,1);
+            }
+            else
+                cv::cvtColor(source,frame,CV_YUV2BGR_YUYV);
+        }
+        else
+        {
+            cv::Mat source(height,width,CV_8UC3,b.start,bytesPerLine);
+            cv::cvtColor(source,frame,CV_BGR2GRAY);
+        }
+    }
+    return b.frame;
+#else
+    Q_UNUSED(timeout);
+    return NULL;
+#endif
+} // dequeueFrame()
+
+int V4L2Capture::dequeueBuffer(int timeout, const uchar **data, int *size)
+{
+#ifdef __linux__
+    if(!streaming)
+        return -1;
+    // Wait for a buffer to be released if driver owns no buffer (driver can not capture)
+    mutex.lock();
+    if(nQueued==0)
+        bufferQueued.wait(&mutex,timeout);
+    bool noBufferQueued=(nQueued==0);
+    mutex.unlock();
+    if(noBufferQueued)
+        return -1;
+    // Wait for a filled buffer (-1 is returned on timeout: caller can check for stop request)
+    struct pollfd pollFd;
+    pollFd.fd=fd;
+    pollFd.events=POLLIN;
+    pollFd.revents=0;
+    int r=poll(&pollFd,1,timeout);
+    if(r<=0)
+    {
+        if((r<0)&&(errno!=EINTR))
+            qDebug() << "ERROR: Could not wait for V4L2 frame.";
+        return -1;
+    }
+    struct v4l2_buffer buffer;
+    memset(&buffer,0,sizeof(buffer));
+    buffer.type=V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory=V4L2_MEMORY_MMAP;
+    if(xioctl(fd,VIDIOC_DQBUF,&buffer)==-1)
+    {
+        if(errno!=EAGAIN)
+            qDebug() << "ERROR: Could not dequeue V4L2 buffer.";
+        return -1;
+    }
+    mutex.lock();
+    buffers[buffer.index].queued=false;
+    nQueued--;
+    mutex.unlock();
+    // Data of buffer (valid until buffer is released)
+    if(data!=NULL)
+        *data=(const uchar*)buffers[buffer.index].start;
+    if(size!=NULL)
+        *size=buffer.bytesused;
+    return buffer.index;
+#else
+    Q_UNUSED(timeout);
+    Q_UNUSED(data);
+    Q_UNUSED(size);
+    return -1;
+#endif
+} // dequeueBuffer()
+
+void V4L2Capture::releaseFrame(IplImage *frame)
+{
+    // Driver buffer of frame is queued again
+    for(unsigned int i=0;i<buffers.size();i++)
+    {
+        if(buffers[i].frame==frame)
+        {
+            releaseBuffer(i);
+            return;
+        }
+    }
+    qDebug() << "ERROR: Released frame was not captured by V4L2 capture.";
+} // releaseFrame()
+
+void V4L2Capture::releaseBuffer(int index)
+{
+    // Buffer is queued again (driver can capture into it)
+    QMutexLocker locker(&mutex);
+    if(streaming&&(index<(int)buffers.size())&&!buffers[index].queued&&queueBuffer(index))
+        bufferQueued.wakeAll();
+} // releaseBuffer()
+
+bool V4L2Capture::queueBuffer(int index)
+{
+#ifdef __linux__
+    struct v4l2_buffer buffer;
+    memset(&buffer,0,sizeof(buffer));
+    buffer.type=V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory=V4L2_MEMORY_MMAP;
+    buffer.index=index;
+    if(xioctl(fd,VIDIOC_QBUF,&buffer)==-1)
+    {
+        qDebug() << "ERROR: Could not queue V4L2 buffer.";
+        return false;
+    }
+    buffers[index].queued=true;
+    nQueued++;
+    return true;
+#else
+    Q_UNUSED(index);
+    return false;
+#endif
+} // queueBuffer()
+
+bool V4L2Capture::isZeroCopy()
+{
+#ifdef __linux__
+    // GREY frames are handed out as luma frames (also if luma capture is OFF)
+    return (pixelFormat==V4L2_PIX_FMT_GREY)||((pixelFormat==V4L2_PIX_FMT_BGR24)&&!lumaOn);
+#else
+    return false;
+#endif
+} // isZeroCopy()
+
+bool V4L2Capture::isCompressed()
+{
+#ifdef __linux__
+    return (pixelFormat==V4L2_PIX_FMT_MJPEG)||(pixelFormat==V4L2_PIX_FMT_JPEG);
+#else
+    return false;
+#endif
+} // isCompressed()
+
+int V4L2Capture::getWidth()
+{
+    return width;
+} // getWidth()
+
+int V4L2Capture::getHeight()
+{
+    return height;
+} // getHeight()
+
+double V4L2Capture::getFPS()
+{
+    return fps;
+} // getFPS()
+
+QList<CaptureMode> V4L2Capture::getModes(int deviceNumber)
+{
+    QList<CaptureMode> modes;
+#ifdef __linux__
+    // Enumerate pixel formats, frame sizes and frame intervals supported by device
+    // (stepwise frame sizes and intervals are listed at their maximum)
+    QString deviceName=QString("/dev/video%1").arg(deviceNumber);
+    int fd=::open(deviceName.toLocal8Bit().constData(),O_RDWR|O_NONBLOCK);
+    if(fd<0)
+        return modes;
+    struct v4l2_fmtdesc formatDescription;
+    memset(&formatDescription,0,sizeof(formatDescription));
+    formatDescription.type=V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    for(;xioctl(fd,VIDIOC_ENUM_FMT,&formatDescription)==0;formatDescription.index++)
+    {
+        unsigned int pixelFormat=formatDescription.pixelformat;
+        char fourcc[5]={(char)(pixelFormat&0xFF),(char)((pixelFormat>>8)&0xFF),(char)((pixelFormat>>16)&0xFF),(char)((pixelFormat>>24)&0xFF),0};
+        struct v4l2_frmsizeenum frameSize;
+        memset(&frameSize,0,sizeof(frameSize));
+        frameSize.pixel_format=pixelFormat;
+        for(;xioctl(fd,VIDIOC_ENUM_FRAMESIZES,&frameSize)==0;frameSize.index++)
+        {
+            CaptureMode mode;
+            mode.decodeScale=1;
+            mode.fourcc=QString::fromLatin1(fourcc).trimmed();
+            if(frameSize.type==V4L2_FRMSIZE_TYPE_DISCRETE)
+            {
+                mode.width=frameSize.discrete.width;
+                mode.height=frameSize.discrete.height;
+            }
+            else
+            {
+                mode.width=frameSize.stepwise.max_width;
+                mode.height=frameSize.stepwise.max_height;
+            }
+            struct v4l2_frmivalenum frameInterval;
+            memset(&frameInterval,0,sizeof(frameInterval));
+            frameInterval.pixel_format=pixelFormat;
+            frameInterval.width=mode.width;
+            frameInterval.height=mode.height;
+            int nIntervals=0;
+            for(;xioctl(fd,VIDIOC_ENUM_FRAMEINTERVALS,&frameInterval)==0;frameInterval.index++)
+            {
+                struct v4l2_fract interval=(frameInterval.type==V4L2_FRMIVAL_TYPE_DISCRETE) ?
+                                           frameInterval.discrete : frameInterval.stepwise.min;
+                mode.fps=(interval.numerator>0) ? (double)interval.denominator/interval.numerator : 0;
+                modes.append(mode);
+                nIntervals++;
+                if(frameInterval.type!=V4L2_FRMIVAL_TYPE_DISCRETE)
+                    break;
+            }
+            // Frame rate unknown
+            if(nIntervals==0)
+            {
+                mode.fps=0;
+                modes.append(mode);
+            }
+            if(frameSize.type!=V4L2_FRMSIZE_TYPE_DISCRETE)
+                break;
+        }
+    }
+    ::close(fd);
+#else
+    Q_UNUSED(deviceNumber);
+#endif
+    return modes;
+} // getModes()
@@ -0,0 +1,99 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* V4L2Capture.h                                                        */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+#ifndef V4L2CAPTURE_H
+#define V4L2CAPTURE_H
+
+#include "ImageBuffer.h"
+#include "Structures.h"
+
+// Qt header files
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+// OpenCV header files
+#include <opencv/cv.h>
+
+#include <vector>
+
+// Mapped driver buffer and the frame handed out for it
+struct V4L2Buffer{
+    void *start;
+    size_t length;
+    IplImage *frame; // Header on mapped memory (zero copy) or converted frame
+    bool queued; // Buffer is owned by driver
+};
+
+// Video capture through V4L2 streaming I/O with memory-mapped driver buffers.
+// Frames are handed out without copying (the driver buffer is wrapped by the frame) if the driver delivers BGR24
+// (or GREY if luma capture is ON); YUYV is converted once from the mapped buffer. A driver buffer is queued again
+// only when its frame is released, so frames can be added to the image buffer as they are.
+// Compressed (MJPG) buffers are handed out as they are (dequeueBuffer()) and released after decoding.
+class V4L2Capture : public FrameOwner
+{
+
+public:
+    V4L2Capture();
+    ~V4L2Capture();
+    bool open(int deviceNumber, bool lumaOn, int nBuffers, const CaptureMode &mode);
+    void close();
+    bool isOpened();
+    IplImage* dequeueFrame(int timeout);
+    int dequeueBuffer(int timeout, const uchar **data, int *size);
+    void releaseFrame(IplImage *frame);
+    void releaseBuffer(int index);
+    bool isZeroCopy();
+    bool isCompressed();
+    int getWidth();
+    int getHeight();
+    double getFPS();
+    static QList<CaptureMode> getModes(int deviceNumber);
+private:
+    bool openDevice(int deviceNumber, bool lumaOn, int nBuffers, const CaptureMode &mode);
+    bool queueBuffer(int index);
+    QMutex mutex;
+    QWaitCondition bufferQueued;
+    int nQueued;
+    int fd;
+    int width;
+    int height;
+    double fps;
+    unsigned int pixelFormat;
+    int bytesPerLine;
+    bool lumaOn;
+    bool streaming;
+    std::vector<V4L2Buffer> buffers;
+};
+
+#endif // V4L2CAPTURE_H
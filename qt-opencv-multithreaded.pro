@@ -13,17 +13,32 @@ SOURCES += main.cpp\
         MainWindow.cpp \
     CaptureThread.cpp \
     Controller.cpp \
+    CameraPipeline.cpp \
     ImageBuffer.cpp \
     CameraConnectDialog.cpp \
     ProcessingThread.cpp \
     ShowIplImage.cpp \
     FrameLabel.cpp \
     ProcessingSettingsDialog.cpp \
-    FaceDetect.cpp
+    FaceDetect.cpp \
+    FaceDetectThread.cpp \
+    FaceTracker.cpp \
+    SearchRegionPredictor.cpp \
+    CascadeCache.cpp \
+    HaarCascade.cpp \
+    DetectionEngine.cpp \
+    DetectionBudget.cpp \
+    MotionDetector.cpp \
+    BackgroundModel.cpp \
+    BlobExtractor.cpp \
+    ParallelCanny.cpp \
+    V4L2Capture.cpp \
+    MjpegDecoder.cpp
 
 HEADERS  += MainWindow.h \
     CaptureThread.h \
     Controller.h \
+    CameraPipeline.h \
     ImageBuffer.h \
     CameraConnectDialog.h \
     DefaultValues.h \
@@ -32,6 +47,19 @@ HEADERS  += MainWindow.h \
     FrameLabel.h \
     ProcessingSettingsDialog.h \
     Structures.h \
-    FaceDetect.h
+    FaceDetect.h \
+    FaceDetectThread.h \
+    FaceTracker.h \
+    SearchRegionPredictor.h \
+    CascadeCache.h \
+    HaarCascade.h \
+    DetectionEngine.h \
+    DetectionBudget.h \
+    MotionDetector.h \
+    BackgroundModel.h \
+    BlobExtractor.h \
+    ParallelCanny.h \
+    V4L2Capture.h \
+    MjpegDecoder.h
 
-LIBS += -lopencv_core -lopencv_imgproc -lopencv_highgui -lopencv_ml -lopencv_video -lopencv_features2d -lopencv_calib3d -lopencv_objdetect -lopencv_contrib -lopencv_legacy -lopencv_flann
+LIBS += -lopencv_core -lopencv_imgproc -lopencv_highgui -lopencv_ml -lopencv_video -lopencv_features2d -lopencv_calib3d -lopencv_objdetect -lopencv_contrib -lopencv_legacy -lopencv_flann -ljpeg
@@ -0,0 +1,15 @@
+QT       += core
+
+TARGET = benchmark-canny
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../ParallelCanny.cpp
+
+HEADERS += ../../ParallelCanny.h
+
+LIBS += -lopencv_core -lopencv_imgproc -lopencv_highgui
@@ -0,0 +1,183 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* benchmark-cascade/main.cpp                                           */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+// Checks and benchmarks the parallel Canny stage against cvCanny() on the same frames:
+//   benchmark-canny [<image or video file> ...]
+// Without files, synthetic 4K frames are used. Frames are converted to grayscale and both implementations are run
+// for each aperture size and several threshold pairs. Reports time per frame of each implementation and the number
+// of pixels that differ (exit code 1 if any pixel differs: outputs must be identical). Both implementations are also
+// run in place on an ROI of each frame (as by the processing thread): pixels outside the ROI are read, not written.
+
+#include "ParallelCanny.h"
+
+// Qt header files
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QTime>
+// OpenCV header files
+#include <opencv/cv.h>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <vector>
+
+// Maximum number of frames read from each video file
+#define BENCHMARK_MAX_VIDEO_FRAMES 100
+// Synthetic frames (used if no files are given)
+#define BENCHMARK_SYNTHETIC_FRAMES 10
+#define BENCHMARK_SYNTHETIC_WIDTH 3840
+#define BENCHMARK_SYNTHETIC_HEIGHT 2160
+
+// Threshold pairs (low, high): second pair is swapped by both implementations
+static const double thresholds[][2]={{10,100},{100,10},{50,150},{0,0},{200,800}};
+static const int nThresholds=sizeof(thresholds)/sizeof(thresholds[0]);
+
+static void addFrame(const cv::Mat &image, std::vector<cv::Mat> &frames)
+{
+    cv::Mat gray;
+    if(image.channels()==3)
+        cv::cvtColor(image,gray,CV_BGR2GRAY);
+    else
+        gray=image.clone();
+    frames.push_back(gray);
+} // addFrame()
+
+static void addSyntheticFrames(std::vector<cv::Mat> &frames)
+{
+    // Noisy frames with shapes of different contrast (edges of all directions and strengths)
+    cv::RNG rng(12345);
+    for(int f=0;f<BENCHMARK_SYNTHETIC_FRAMES;f++)
+    {
+        cv::Mat frame(BENCHMARK_SYNTHETIC_HEIGHT,BENCHMARK_SYNTHETIC_WIDTH,CV_8UC1);
+        rng.fill(frame,cv::RNG::UNIFORM,cv::Scalar(60),cv::Scalar(80));
+        for(int i=0;i<200;i++)
+        {
+            cv::Point center(rng.uniform(0,frame.cols),rng.uniform(0,frame.rows));
+            int color=rng.uniform(0,256);
+            if(i%2==0)
+                cv::circle(frame,center,rng.uniform(5,300),cv::Scalar(color),-1);
+            else
+                cv::rectangle(frame,center,center+cv::Point(rng.uniform(-300,300),rng.uniform(-300,300)),cv::Scalar(color),-1);
+        }
+        cv::GaussianBlur(frame,frame,cv::Size(5,5),rng.uniform(0.5,2.0));
+        frames.push_back(frame);
+    }
+} // addSyntheticFrames()
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+    QStringList arguments=a.arguments();
+    std::vector<cv::Mat> frames;
+    // Read frames (file is read as video if it can not be read as image)
+    for(int i=1;i<arguments.size();i++)
+    {
+        std::string filename=arguments.at(i).toUtf8().constData();
+        cv::Mat image=cv::imread(filename);
+        if(!image.empty())
+        {
+            addFrame(image,frames);
+            continue;
+        }
+        cv::VideoCapture capture(filename);
+        for(int n=0;(n<BENCHMARK_MAX_VIDEO_FRAMES)&&capture.read(image);n++)
+            addFrame(image,frames);
+    }
+    if(arguments.size()<2)
+        addSyntheticFrames(frames);
+    if(frames.empty())
+    {
+        out << "ERROR: No frames could be read" << endl;
+        return 1;
+    }
+    out << "Frames: " << frames.size() << " (" << frames[0].cols << "x" << frames[0].rows << ")" << endl;
+    // Run both implementations on all frames
+    ParallelCanny parallelCanny;
+    cv::Mat reference, edges, referenceFrame, parallelFrame;
+    long long nDifferent=0;
+    for(int apertureSize=3;apertureSize<=7;apertureSize+=2)
+    {
+        for(int t=0;t<nThresholds;t++)
+        {
+            // Thresholds scaled with gradient magnitude of aperture (Sobel kernel sums: 3x3 1, 5x5 4, 7x7 20)
+            double scale=(apertureSize==3) ? 1 : ((apertureSize==5) ? 4 : 20);
+            double threshold1=thresholds[t][0]*scale;
+            double threshold2=thresholds[t][1]*scale;
+            int cvCannyTime=0;
+            int parallelCannyTime=0;
+            long long nDifferentPixels=0;
+            QTime timer;
+            for(unsigned int f=0;f<frames.size();f++)
+            {
+                reference.create(frames[f].size(),CV_8UC1);
+                IplImage source=frames[f];
+                IplImage destination=reference;
+                timer.start();
+                cvCanny(&source,&destination,threshold1,threshold2,apertureSize);
+                cvCannyTime+=timer.elapsed();
+                timer.start();
+                parallelCanny.apply(frames[f],edges,threshold1,threshold2,apertureSize);
+                parallelCannyTime+=timer.elapsed();
+                cv::Mat difference;
+                cv::compare(reference,edges,difference,cv::CMP_NE);
+                nDifferentPixels+=cv::countNonZero(difference);
+                // In place on ROI (submatrix): whole frames are compared
+                cv::Rect roi(frames[f].cols/8,frames[f].rows/8,frames[f].cols/2,frames[f].rows/2);
+                referenceFrame=frames[f].clone();
+                parallelFrame=frames[f].clone();
+                IplImage referenceImage=referenceFrame;
+                cvSetImageROI(&referenceImage,roi);
+                cvCanny(&referenceImage,&referenceImage,threshold1,threshold2,apertureSize);
+                cv::Mat parallelRoi=parallelFrame(roi);
+                parallelCanny.apply(parallelRoi,parallelRoi,threshold1,threshold2,apertureSize);
+                cv::compare(referenceFrame,parallelFrame,difference,cv::CMP_NE);
+                nDifferentPixels+=cv::countNonZero(difference);
+            }
+            nDifferent+=nDifferentPixels;
+            out << "aperture " << apertureSize << ", thresholds " << threshold1 << "/" << threshold2 << ": "
+                << "cvCanny() " << QString::number((double)cvCannyTime/frames.size(),'f',2) << " ms/frame, "
+                << "ParallelCanny " << QString::number((double)parallelCannyTime/frames.size(),'f',2) << " ms/frame, "
+                << nDifferentPixels << " pixels differ" << endl;
+        }
+    }
+    if(nDifferent>0)
+    {
+        out << "ERROR: Outputs differ" << endl;
+        return 1;
+    }
+    out << "Outputs identical" << endl;
+    return 0;
+} // main()
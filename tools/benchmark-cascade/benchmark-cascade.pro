@@ -0,0 +1,19 @@
+QT       += core gui
+
+TARGET = benchmark-cascade
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../HaarCascade.cpp \
+    ../../CascadeCache.cpp \
+    ../../DetectionEngine.cpp
+
+HEADERS += ../../HaarCascade.h \
+    ../../CascadeCache.h \
+    ../../DetectionEngine.h
+
+LIBS += -lopencv_core -lopencv_imgproc -lopencv_highgui -lopencv_objdetect
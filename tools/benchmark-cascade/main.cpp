@@ -0,0 +1,221 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* benchmark-cascade/main.cpp                                           */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+// Benchmarks cascade evaluators on the same frames:
+//   benchmark-cascade <cascade.xml> <image or video file> [<image or video file> ...]
+// Frames are prepared as for face detection (grayscale, equalized) and each evaluator is run on all frames
+// with the default detector parameters. Reports time per frame and number of detections of each evaluator
+// (and on how many frames the detections are identical to those of cv::CascadeClassifier).
+// Exits with status 1 if an in-tree evaluator reports a different set of (ungrouped) windows than
+// cv::CascadeClassifier on any frame.
+
+#include "CascadeCache.h"
+#include "DefaultValues.h"
+#include "DetectionEngine.h"
+#include "HaarCascade.h"
+
+// Qt header files
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QTime>
+// OpenCV header files
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include <algorithm>
+#include <vector>
+
+// Maximum number of frames read from each video file
+#define BENCHMARK_MAX_VIDEO_FRAMES 100
+
+// Cascade evaluators
+enum Evaluator { OPENCV, SCALAR, SIMD, ENGINE, N_EVALUATORS };
+static const char *evaluatorNames[N_EVALUATORS]={"cv::CascadeClassifier",
+                                                 "in-tree (scalar)",
+                                                 "in-tree (SIMD)",
+                                                 "in-tree (SIMD, multithreaded)"};
+
+// Sleeps in the calling thread (QThread::msleep() is protected in Qt 4)
+class Sleeper : public QThread
+{
+
+public:
+    static void msleep(unsigned long msecs) { QThread::msleep(msecs); }
+};
+
+// Orders detections by position (evaluators may report the same detections in a different order)
+static bool rectLessThan(const cv::Rect &r1, const cv::Rect &r2)
+{
+    if(r1.y!=r2.y)
+        return r1.y<r2.y;
+    if(r1.x!=r2.x)
+        return r1.x<r2.x;
+    return r1.width<r2.width;
+} // rectLessThan()
+
+static void addFrame(const cv::Mat &image, std::vector<cv::Mat> &frames)
+{
+    // Prepare frame as for face detection
+    cv::Mat gray;
+    if(image.channels()==3)
+        cv::cvtColor(image,gray,CV_BGR2GRAY);
+    else
+        gray=image;
+    cv::Mat frame;
+    cv::equalizeHist(gray,frame);
+    frames.push_back(frame);
+} // addFrame()
+
+static void detect(int evaluator, cv::CascadeClassifier &classifier, HaarCascade *haarCascade,
+                   DetectionEngine &engine, const std::vector<CascadeHandle> &cascades,
+                   const cv::Mat &frame, std::vector<cv::Rect> &objects, int minNeighbors=2)
+{
+    // Local variables
+    std::vector<std::vector<cv::Rect> > engineObjects;
+    cv::Size minSize(DEFAULT_FACEDETECT_MIN_SIZE,DEFAULT_FACEDETECT_MIN_SIZE);
+    switch(evaluator)
+    {
+        case OPENCV:
+            classifier.detectMultiScale(frame,objects,DEFAULT_FACEDETECT_SCALE_FACTOR,minNeighbors,CV_HAAR_SCALE_IMAGE,minSize);
+            break;
+        case SCALAR:
+        case SIMD:
+            HaarCascade::setSimdEnabled(evaluator==SIMD);
+            haarCascade->detectMultiScale(frame,objects,DEFAULT_FACEDETECT_SCALE_FACTOR,minNeighbors,minSize);
+            break;
+        case ENGINE:
+            HaarCascade::setSimdEnabled(true);
+            engine.detect(frame,cascades,DEFAULT_FACEDETECT_SCALE_FACTOR,minNeighbors,minSize,cv::Size(),engineObjects);
+            objects=engineObjects[0];
+            break;
+    }
+    std::sort(objects.begin(),objects.end(),rectLessThan);
+} // detect()
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+    QStringList arguments=a.arguments();
+    std::vector<cv::Mat> frames;
+    if(arguments.size()<3)
+    {
+        out << "Usage: benchmark-cascade <cascade.xml> <image or video file> [<image or video file> ...]" << endl;
+        return 1;
+    }
+    // Read frames (file is read as video if it can not be read as image)
+    for(int i=2;i<arguments.size();i++)
+    {
+        std::string filename=arguments.at(i).toUtf8().constData();
+        cv::Mat image=cv::imread(filename);
+        if(!image.empty())
+        {
+            addFrame(image,frames);
+            continue;
+        }
+        cv::VideoCapture capture(filename);
+        for(int n=0;(n<BENCHMARK_MAX_VIDEO_FRAMES)&&capture.read(image);n++)
+            addFrame(image,frames);
+    }
+    if(frames.empty())
+    {
+        out << "ERROR: No frames could be read" << endl;
+        return 1;
+    }
+    // Load cascade with both evaluators
+    cv::CascadeClassifier classifier;
+    if(!classifier.load(arguments.at(1).toUtf8().constData()))
+    {
+        out << "ERROR: Can not open cascade file: " << arguments.at(1) << endl;
+        return 1;
+    }
+    std::vector<CascadeHandle> cascades(1,CascadeCache::getCascade(arguments.at(1)));
+    while(cascades[0]->isLoading())
+        Sleeper::msleep(10);
+    HaarCascade *haarCascade=cascades[0]->getHaarCascade();
+    DetectionEngine engine;
+    int nEvaluators=(haarCascade!=NULL) ? N_EVALUATORS : 1;
+    if(haarCascade==NULL)
+        out << "Cascade can not be evaluated in-tree (no binary cascade): only cv::CascadeClassifier is run" << endl;
+    else
+        out << "Cascade: " << (haarCascade->isStumpBased() ? "stump-based" : "tree-based (SIMD evaluator not used)")
+            << ", SIMD level: " << HaarCascade::getSimdLevel() << endl;
+    out << "Frames: " << frames.size() << " (" << frames[0].cols << "x" << frames[0].rows << ")" << endl;
+    // Run each evaluator on all frames (first frame is evaluated once beforehand: loading and allocations are not timed)
+    std::vector<std::vector<std::vector<cv::Rect> > > objects(N_EVALUATORS,std::vector<std::vector<cv::Rect> >(frames.size()));
+    for(int e=0;e<nEvaluators;e++)
+    {
+        std::vector<cv::Rect> warmUp;
+        detect(e,classifier,haarCascade,engine,cascades,frames[0],warmUp);
+        QTime t;
+        t.start();
+        for(unsigned int f=0;f<frames.size();f++)
+            detect(e,classifier,haarCascade,engine,cascades,frames[f],objects[e][f]);
+        int elapsed=t.elapsed();
+        int nDetections=0;
+        int nIdentical=0;
+        for(unsigned int f=0;f<frames.size();f++)
+        {
+            nDetections+=(int)objects[e][f].size();
+            if(objects[e][f]==objects[OPENCV][f])
+                nIdentical++;
+        }
+        out << evaluatorNames[e] << ": " << QString::number((double)elapsed/frames.size(),'f',2) << " ms/frame, "
+            << nDetections << " detections, identical to cv::CascadeClassifier on "
+            << nIdentical << "/" << frames.size() << " frames" << endl;
+    }
+    // Compare ungrouped windows (minNeighbors=0) of each in-tree evaluator with those of cv::CascadeClassifier
+    int status=0;
+    for(unsigned int f=0;f<frames.size();f++)
+    {
+        std::vector<cv::Rect> expected;
+        detect(OPENCV,classifier,haarCascade,engine,cascades,frames[f],expected,0);
+        for(int e=OPENCV+1;e<nEvaluators;e++)
+        {
+            std::vector<cv::Rect> windows;
+            detect(e,classifier,haarCascade,engine,cascades,frames[f],windows,0);
+            if(windows!=expected)
+            {
+                out << "ERROR: " << evaluatorNames[e]
+                    << ": windows differ from cv::CascadeClassifier on frame " << f << " ("
+                    << windows.size() << " vs " << expected.size() << " windows)" << endl;
+                status=1;
+            }
+        }
+    }
+    return status;
+} // main()
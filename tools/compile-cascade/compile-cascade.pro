@@ -0,0 +1,16 @@
+QT       += core
+QT       -= gui
+
+TARGET = compile-cascade
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../HaarCascade.cpp
+
+HEADERS += ../../HaarCascade.h
+
+LIBS += -lopencv_core -lopencv_imgproc -lopencv_objdetect
@@ -0,0 +1,70 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* compile-cascade/main.cpp                                             */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+
+
+// Converts XML haarcascades into the binary cascade format used by HaarCascade:
+//   compile-cascade <cascade.xml> [<cascade.xml> ...]
+// Each binary cascade is written next to its XML file (<name>.bin), where it is picked up
+// automatically in place of the XML file.
+
+#include "HaarCascade.h"
+
+// Qt header files
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+    QStringList arguments=a.arguments();
+    int nFailed=0;
+    if(arguments.size()<2)
+    {
+        out << "Usage: compile-cascade <cascade.xml> [<cascade.xml> ...]" << endl;
+        return 1;
+    }
+    for(int i=1;i<arguments.size();i++)
+    {
+        QString binaryFilename=HaarCascade::binaryFilename(arguments.at(i));
+        if(HaarCascade::compile(arguments.at(i),binaryFilename))
+            out << arguments.at(i) << " -> " << binaryFilename << endl;
+        else
+        {
+            out << arguments.at(i) << ": FAILED (XML cascade will be used)" << endl;
+            nFailed++;
+        }
+    }
+    return (nFailed==0) ? 0 : 1;
+} // main()
@@ -0,0 +1,230 @@
+/************************************************************************/
+/* qt-opencv-multithreaded:                                             */
+/* A multithreaded OpenCV application using the Qt framework.           */
+/*                                                                      */
+/* test-v4l2-capture/main.cpp                                           */
+/*                                                                      */
+/* Nick D'Ademo <nickdademo@gmail.com>                                  */
+/*                                                                      */
+/* Copyright (c) 2011 Nick D'Ademo                                      */
+/*                                                                      */
+/* Permission is hereby granted, free of charge, to any person          */
+/* obtaining a copy of this software and associated documentation       */
+/* files (the "Software"), to deal in the Software without restriction, */
+/* including without limitation the rights to use, copy, modify, merge, */
+/* publish, distribute, sublicense, and/or sell copies of the Software, */
+/* and to permit persons to whom the Software is furnished to do so,    */
+/* subject to the following conditions:                                 */
+/*                                                                      */
+/* The above copyright notice and this permission notice shall be       */
+/* included in all copies or substantial portions of the Software.      */
+/*                                                                      */
+/* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,      */
+/* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF   */
+/* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND                */
+/* NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS  */
+/* BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN   */
+/* ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN    */
+/* CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE     */
+/* SOFTWARE.                                                            */
+/*                                                                      */
+/************************************************************************/
+
+// Checks V4L2 capture without a camera on a v4l2loopback device:
+//   test-v4l2-capture <loopback device number> [<frames per format>]
+// Frames with a known pattern are written to the loopback device (BGR24, GREY and YUYV) and captured through
+// V4L2Capture. Captured frames are held for a while (as in the image buffer) before they are released: their content
+// is checked again on release, so a driver buffer queued again too early is detected. Exit code 1 if any frame is
+// missing or differs from the written frame.
+
+#include "V4L2Capture.h"
+// Header file containing default values
+#include "DefaultValues.h"
+
+// Qt header files
+#include <QCoreApplication>
+#include <QQueue>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QTime>
+// OpenCV header files
+#include <opencv/cv.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/videodev2.h>
+
+// Frames written to loopback device
+#define TEST_WIDTH 640
+#define TEST_HEIGHT 480
+#define TEST_WRITE_INTERVAL 20 // ms
+#define TEST_DEFAULT_FRAMES 100
+// Frames held by test (image buffer size)
+#define TEST_HELD_FRAMES 3
+// Time allowed for each format (ms)
+#define TEST_TIMEOUT 10000
+
+// Byte j of row y of frame k (frame number is found from first byte: 183 is the inverse of 7 modulo 256)
+static inline uchar patternByte(int j, int y, int k)
+{
+    return (uchar)((j+3*y+7*k)&255);
+} // patternByte()
+
+static inline int patternFrame(uchar firstByte)
+{
+    return (firstByte*183)&255;
+} // patternFrame()
+
+// Writes pattern frames to the output side of the loopback device until stopped
+class FrameWriter : public QThread
+{
+
+public:
+    FrameWriter(int fd, int bytesPerLine) : fd(fd), bytesPerLine(bytesPerLine), stopped(false) {}
+    void stop()
+    {
+        stopped=true;
+    }
+protected:
+    void run()
+    {
+        std::vector<uchar> frame(bytesPerLine*TEST_HEIGHT);
+        for(int k=0;!stopped;k++)
+        {
+            for(int y=0;y<TEST_HEIGHT;y++)
+                for(int j=0;j<bytesPerLine;j++)
+                    frame[y*bytesPerLine+j]=patternByte(j,y,k);
+            if(write(fd,&frame[0],frame.size())!=(ssize_t)frame.size())
+                return;
+            msleep(TEST_WRITE_INTERVAL);
+        }
+    }
+private:
+    int fd;
+    int bytesPerLine;
+    volatile bool stopped;
+};
+
+// Checks captured frame against pattern (frame number is found from first pixel); returns frame number or -1
+static int checkFrame(const IplImage *frame, unsigned int pixelFormat, bool lumaOn)
+{
+    // Expected frame: BGR24 and GREY frames hold written bytes, luma of YUYV frames holds even bytes
+    bool yuyvLuma=(pixelFormat==V4L2_PIX_FMT_YUYV);
+    int channels=((pixelFormat==V4L2_PIX_FMT_BGR24)&&!lumaOn) ? 3 : 1;
+    if((frame->width!=TEST_WIDTH)||(frame->height!=TEST_HEIGHT)||(frame->nChannels!=channels))
+        return -1;
+    int k=patternFrame((uchar)frame->imageData[0]);
+    for(int y=0;y<frame->height;y++)
+    {
+        const uchar *row=(const uchar*)frame->imageData+y*frame->widthStep;
+        for(int j=0;j<frame->width*channels;j++)
+        {
+            if(row[j]!=patternByte(yuyvLuma ? 2*j : j,y,k))
+                return -1;
+        }
+    }
+    return k;
+} // checkFrame()
+
+static bool testFormat(QTextStream &out, int deviceNumber, unsigned int pixelFormat, int bytesPerPixel, bool lumaOn, int nFrames)
+{
+    // Set format of output side and start writing
+    QString deviceName=QString("/dev/video%1").arg(deviceNumber);
+    int fd=open(deviceName.toLocal8Bit().constData(),O_WRONLY);
+    if(fd<0)
+    {
+        out << "ERROR: Could not open " << deviceName << endl;
+        return false;
+    }
+    struct v4l2_format format;
+    memset(&format,0,sizeof(format));
+    format.type=V4L2_BUF_TYPE_VIDEO_OUTPUT;
+    format.fmt.pix.width=TEST_WIDTH;
+    format.fmt.pix.height=TEST_HEIGHT;
+    format.fmt.pix.pixelformat=pixelFormat;
+    format.fmt.pix.field=V4L2_FIELD_NONE;
+    format.fmt.pix.bytesperline=TEST_WIDTH*bytesPerPixel;
+    format.fmt.pix.sizeimage=TEST_WIDTH*TEST_HEIGHT*bytesPerPixel;
+    if(ioctl(fd,VIDIOC_S_FMT,&format)==-1)
+    {
+        out << "ERROR: Could not set format of " << deviceName << " (is it a v4l2loopback device?)" << endl;
+        close(fd);
+        return false;
+    }
+    FrameWriter writer(fd,TEST_WIDTH*bytesPerPixel);
+    writer.start();
+    usleep(200000);
+    // Capture frames and hold them before releasing (content is checked when captured and when released)
+    V4L2Capture capture;
+    CaptureMode mode={TEST_WIDTH,TEST_HEIGHT,0,QString(),1};
+    bool ok=capture.open(deviceNumber,lumaOn,TEST_HELD_FRAMES+DEFAULT_V4L2_EXTRA_BUFFERS,mode);
+    int nCaptured=0;
+    int nErrors=0;
+    if(ok)
+    {
+        QQueue<IplImage*> held;
+        QQueue<int> heldNumbers;
+        QTime timer;
+        timer.start();
+        while((nCaptured<nFrames)&&(timer.elapsed()<TEST_TIMEOUT))
+        {
+            IplImage *frame=capture.dequeueFrame(DEFAULT_V4L2_DEQUEUE_TIMEOUT);
+            if(frame==NULL)
+                continue;
+            nCaptured++;
+            int k=checkFrame(frame,pixelFormat,lumaOn);
+            if(k<0)
+                nErrors++;
+            held.enqueue(frame);
+            heldNumbers.enqueue(k);
+            if(held.size()>TEST_HELD_FRAMES)
+            {
+                IplImage *released=held.dequeue();
+                if(checkFrame(released,pixelFormat,lumaOn)!=heldNumbers.dequeue())
+                    nErrors++;
+                capture.releaseFrame(released);
+            }
+        }
+        while(!held.empty())
+            capture.releaseFrame(held.dequeue());
+        out << "  " << nCaptured << " frames captured" << (capture.isZeroCopy() ? " (zero copy)" : " (converted)")
+            << ", " << nErrors << " differ" << endl;
+        capture.close();
+    }
+    writer.stop();
+    writer.wait();
+    close(fd);
+    return ok&&(nCaptured==nFrames)&&(nErrors==0);
+} // testFormat()
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QTextStream out(stdout);
+    QStringList arguments=a.arguments();
+    if(arguments.size()<2)
+    {
+        out << "Usage: test-v4l2-capture <loopback device number> [<frames per format>]" << endl;
+        return 1;
+    }
+    int deviceNumber=arguments.at(1).toInt();
+    int nFrames=(arguments.size()>2) ? arguments.at(2).toInt() : TEST_DEFAULT_FRAMES;
+    bool ok=true;
+    out << "BGR24:" << endl;
+    ok=testFormat(out,deviceNumber,V4L2_PIX_FMT_BGR24,3,false,nFrames)&&ok;
+    out << "GREY, luma capture:" << endl;
+    ok=testFormat(out,deviceNumber,V4L2_PIX_FMT_GREY,1,true,nFrames)&&ok;
+    out << "YUYV, luma capture:" << endl;
+    ok=testFormat(out,deviceNumber,V4L2_PIX_FMT_YUYV,2,true,nFrames)&&ok;
+    if(!ok)
+    {
+        out << "ERROR: Capture test failed" << endl;
+        return 1;
+    }
+    out << "Capture test passed" << endl;
+    return 0;
+} // main()
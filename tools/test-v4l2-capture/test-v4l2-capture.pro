@@ -0,0 +1,16 @@
+QT       += core gui
+
+TARGET = test-v4l2-capture
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+INCLUDEPATH += ../..
+
+SOURCES += main.cpp \
+    ../../V4L2Capture.cpp
+
+HEADERS += ../../V4L2Capture.h \
+    ../../ImageBuffer.h
+
+LIBS += -lopencv_core -lopencv_imgproc